@@ -0,0 +1,252 @@
+// Serializes a chat-list screen the size of a long chat list, with a few message previews
+// under every chat, through engine::ui::build_ui_document and through the previous builder
+// (an ostringstream per element, a string returned per subtree, a string per escape) and
+// prints the time per document for several list sizes.
+//
+// usage: document_builder [documents per run, default 200]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "engine/ui/ui_document.hpp"
+#include "engine/ui/ui_types.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kPreviewsPerChat = 3;
+constexpr std::string_view kTemplate = "<body class=\"screen-join-friend\">\n    {{SCREEN_CONTENT}}\n</body>";
+constexpr std::string_view kStylesheet = ".option-list { display: flex; flex-direction: column; gap: 16px; }";
+
+// keeps the documents from being optimized out
+std::size_t markup_sink = 0;
+
+// the previous design, kept verbatim as the baseline
+class LegacyBuilder {
+public:
+    auto build(engine::ui::UiElement root,
+               std::span<const std::string_view> stylesheets,
+               std::string_view template_markup) -> engine::ui::UiDocument {
+        std::string body_markup = render_element(std::move(root));
+
+        std::string body_template(template_markup);
+        if (body_template.empty()) {
+            body_template = std::string{engine::ui::kScreenContentToken};
+        }
+
+        const auto token_pos = body_template.find(engine::ui::kScreenContentToken);
+        if (token_pos != std::string::npos) {
+            body_template.replace(token_pos, engine::ui::kScreenContentToken.size(), body_markup);
+        } else {
+            body_template.append(body_markup);
+        }
+
+        if (body_template.find("<body") == std::string::npos) {
+            body_template = "<body>" + body_template + "</body>";
+        }
+
+        std::string style_markup;
+        for (const auto sheet : stylesheets) {
+            if (sheet.empty()) {
+                continue;
+            }
+            style_markup += "<style type=\"text/rcss\">\n";
+            style_markup.append(sheet.data(), sheet.size());
+            style_markup += "\n</style>";
+        }
+
+        std::string document;
+        document.reserve(style_markup.size() + body_template.size() + 32);
+        document += "<rml><head>";
+        document += style_markup;
+        document += "</head>";
+        document += body_template;
+        document += "</rml>";
+
+        return engine::ui::UiDocument{
+            .markup = std::move(document),
+            .events = std::move(events_)
+        };
+    }
+
+private:
+    auto render_element(engine::ui::UiElement element) -> std::string {
+        if (element.tag.empty()) {
+            return {};
+        }
+
+        if (element.id.empty() && !element.events.empty()) {
+            element.id = next_auto_id();
+        }
+
+        std::ostringstream oss;
+        oss << "<" << element.tag;
+
+        if (!element.id.empty()) {
+            oss << " id=\"" << element.id << "\"";
+        }
+
+        if (!element.classes.empty()) {
+            oss << " class=\"";
+            for (std::size_t i = 0; i < element.classes.size(); ++i) {
+                oss << element.classes[i];
+                if (i + 1 < element.classes.size()) {
+                    oss << " ";
+                }
+            }
+            oss << "\"";
+        }
+
+        for (const auto& [key, value] : element.attributes) {
+            oss << " " << key << "=\"" << escape(value) << "\"";
+        }
+
+        oss << ">";
+
+        if (element.text.has_value()) {
+            oss << escape(*element.text);
+        }
+
+        for (auto& child : element.children) {
+            oss << render_element(std::move(child));
+        }
+
+        oss << "</" << element.tag << ">";
+
+        for (const auto& event : element.events) {
+            events_.push_back(engine::ui::UiEventBinding{
+                .id = element.id,
+                .type = event.type,
+                .handler = event.handler
+            });
+        }
+
+        return oss.str();
+    }
+
+    static auto escape(std::string_view text) -> std::string {
+        std::string result;
+        result.reserve(text.size());
+        for (const char ch : text) {
+            switch (ch) {
+                case '&':
+                    result.append("&amp;");
+                    break;
+                case '<':
+                    result.append("&lt;");
+                    break;
+                case '>':
+                    result.append("&gt;");
+                    break;
+                case '"':
+                    result.append("&quot;");
+                    break;
+                default:
+                    result.push_back(ch);
+                    break;
+            }
+        }
+        return result;
+    }
+
+    [[nodiscard]] auto next_auto_id() -> std::string {
+        return "ui_auto_" + std::to_string(auto_counter_++);
+    }
+
+    std::vector<engine::ui::UiEventBinding> events_{};
+    int auto_counter_{0};
+};
+
+auto label(std::string text, std::string variant) -> engine::ui::UiElement {
+    engine::ui::UiElement element{};
+    element.tag = "div";
+    element.classes = {"label", std::move(variant)};
+    element.attributes.emplace_back("style", "font-size: 20px;");
+    element.text = std::move(text);
+    return element;
+}
+
+// the join screen's column: a title, the status line and one clickable entry per chat, each
+// holding its latest messages; titles and previews carry characters that need escaping
+auto chat_list_tree(std::size_t chat_count) -> engine::ui::UiElement {
+    engine::ui::UiElement column{};
+    column.tag = "div";
+    column.classes = {"screen-content", "center-column"};
+    column.children.push_back(label("JOIN A FRIEND", "title"));
+    column.children.push_back(label("Select a chat to view history.", "subtitle"));
+
+    engine::ui::UiElement list{};
+    list.tag = "div";
+    list.id = "option-list";
+    list.classes = {"option-list"};
+    for (std::size_t chat = 0; chat < chat_count; ++chat) {
+        engine::ui::UiElement entry{};
+        entry.tag = "button";
+        entry.classes = {"label", "option"};
+        entry.attributes.emplace_back("style", "font-size: 28px;");
+        entry.text = "Chat #" + std::to_string(chat) + " <friends & family>";
+        entry.events.push_back(engine::ui::UiElementEvent{.type = "click", .handler = [] {}});
+        for (std::size_t preview = 0; preview < kPreviewsPerChat; ++preview) {
+            entry.children.push_back(label(
+                "\"see you at " + std::to_string(preview + 7) + "\" & bring snacks <3",
+                "preview"
+            ));
+        }
+        list.children.push_back(std::move(entry));
+    }
+    column.children.push_back(std::move(list));
+    return column;
+}
+
+template <typename Build>
+auto time_per_document(const engine::ui::UiElement& tree, int documents, Build build) -> double {
+    const std::string_view stylesheets[] = {kStylesheet};
+    Clock::duration total{};
+    for (int i = 0; i < documents; ++i) {
+        // both builders consume their tree, so the copy is made outside the timed region
+        auto copy = tree;
+        const auto started = Clock::now();
+        const auto document = build(std::move(copy), std::span<const std::string_view>{stylesheets}, kTemplate);
+        total += Clock::now() - started;
+        markup_sink += document.markup.size() + document.events.size();
+    }
+    return std::chrono::duration<double, std::micro>(total).count() / documents;
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+    const auto documents = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200;
+
+    std::printf("%-8s %12s %16s %16s %9s\n", "chats", "markup KiB", "ostringstream us", "single buffer us", "speedup");
+    for (const std::size_t chats : {100U, 1000U, 5000U}) {
+        const auto tree = chat_list_tree(chats);
+        const std::string_view stylesheets[] = {kStylesheet};
+        const auto markup_size = engine::ui::build_ui_document(tree, stylesheets, kTemplate).markup.size();
+
+        const auto legacy = time_per_document(tree, documents, [](auto root, auto sheets, auto markup) {
+            LegacyBuilder builder{};
+            return builder.build(std::move(root), sheets, markup);
+        });
+        const auto current = time_per_document(tree, documents, [](auto root, auto sheets, auto markup) {
+            return engine::ui::build_ui_document(std::move(root), sheets, markup);
+        });
+
+        std::printf("%-8zu %12.1f %16.1f %16.1f %8.2fx\n",
+                    chats,
+                    static_cast<double>(markup_size) / 1024.0,
+                    legacy,
+                    current,
+                    legacy / current);
+    }
+
+    return markup_sink == 0 ? 1 : 0;
+}
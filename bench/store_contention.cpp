@@ -0,0 +1,190 @@
+// One writer thread dispatches new messages into the selected chat, like the backend
+// handlers do, while reader threads keep taking the current state, like screens do on
+// rebuild. Runs the same load against engine::store::Store and against a store that
+// guards its state with one mutex (the previous design) and prints throughput and the
+// slowest observed read.
+//
+// usage: store_contention [seconds per run, default 1]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "engine/store/store.hpp"
+#include "game/state/chat_actions.hpp"
+#include "game/state/chat_reducer.hpp"
+#include "game/state/chat_state.hpp"
+
+namespace {
+
+using game::state::ChatAction;
+using game::state::ChatState;
+using Clock = std::chrono::steady_clock;
+
+constexpr engine::backend::ChatId kChatId = 1;
+constexpr std::size_t kInitialHistory = 2000;
+// one read in this many is timed, so the clock does not dominate the loop
+constexpr std::uint64_t kSampleEvery = 64;
+
+// keeps the reads from being optimized out
+std::atomic<std::size_t> read_sink{0};
+
+// the previous design: every access takes the same mutex and readers copy the state
+class LockedStore {
+public:
+    LockedStore(ChatState initial_state, engine::store::Store<ChatState, ChatAction>::Reducer reducer)
+        : state_{std::move(initial_state)},
+          reducer_{std::move(reducer)} {}
+
+    auto state() const -> ChatState {
+        std::lock_guard lock(mutex_);
+        return state_;
+    }
+
+    void dispatch(const ChatAction& action) {
+        std::lock_guard lock(mutex_);
+        state_ = reducer_(state_, action);
+    }
+
+private:
+    mutable std::mutex mutex_{};
+    ChatState state_{};
+    engine::store::Store<ChatState, ChatAction>::Reducer reducer_{};
+};
+
+struct RunResult {
+    std::uint64_t writes{0};
+    std::uint64_t reads{0};
+    std::chrono::nanoseconds slowest_read{0};
+};
+
+auto initial_state() -> ChatState {
+    auto history = std::make_shared<engine::backend::ChatHistory>();
+    history->chat_id = kChatId;
+    for (std::size_t i = kInitialHistory; i > 0; --i) {
+        engine::backend::Message message{};
+        message.id = static_cast<engine::backend::MessageId>(i);
+        message.chat_id = kChatId;
+        message.text = engine::backend::MessageText::copy_of("warm history entry");
+        history->messages.push_back(std::move(message));
+    }
+
+    std::vector<engine::backend::ChatSummary> chats{};
+    for (engine::backend::ChatId id = 1; id <= 5; ++id) {
+        chats.push_back(engine::backend::ChatSummary{.id = id, .title = "chat " + std::to_string(id)});
+    }
+
+    auto state = game::state::reduce_chat_state(ChatState{}, game::state::SetChats{0, std::move(chats)});
+    return game::state::reduce_chat_state(state, game::state::SetChatHistory{std::move(history)});
+}
+
+template <typename Read, typename Write>
+auto run(std::size_t reader_count, std::chrono::milliseconds duration, Read read, Write write) -> RunResult {
+    std::atomic<bool> running{true};
+    std::atomic<std::uint64_t> reads{0};
+    std::atomic<std::int64_t> slowest{0};
+
+    std::vector<std::thread> readers{};
+    for (std::size_t i = 0; i < reader_count; ++i) {
+        readers.emplace_back([&] {
+            std::uint64_t local_reads = 0;
+            std::int64_t local_slowest = 0;
+            std::size_t sink = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                if (local_reads % kSampleEvery == 0) {
+                    const auto started = Clock::now();
+                    sink += read();
+                    const auto took = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started);
+                    local_slowest = std::max(local_slowest, static_cast<std::int64_t>(took.count()));
+                } else {
+                    sink += read();
+                }
+                ++local_reads;
+            }
+            reads.fetch_add(local_reads);
+            auto seen = slowest.load();
+            while (local_slowest > seen && !slowest.compare_exchange_weak(seen, local_slowest)) {
+            }
+            read_sink.fetch_add(sink, std::memory_order_relaxed);
+        });
+    }
+
+    std::uint64_t writes = 0;
+    std::thread writer{[&] {
+        auto next_id = static_cast<engine::backend::MessageId>(kInitialHistory + 1);
+        while (running.load(std::memory_order_relaxed)) {
+            engine::backend::Message message{};
+            message.id = next_id++;
+            message.chat_id = kChatId;
+            write(ChatAction{game::state::AppendMessage{std::move(message)}});
+            ++writes;
+        }
+    }};
+
+    std::this_thread::sleep_for(duration);
+    running = false;
+    writer.join();
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    return RunResult{writes, reads.load(), std::chrono::nanoseconds{slowest.load()}};
+}
+
+void print_row(const char* name, std::size_t readers, std::chrono::milliseconds duration, const RunResult& result) {
+    const double seconds = std::chrono::duration<double>(duration).count();
+    std::printf("%-10s %7zu %14.0f %14.0f %14.1f\n",
+                name,
+                readers,
+                static_cast<double>(result.writes) / seconds,
+                static_cast<double>(result.reads) / seconds,
+                std::chrono::duration<double, std::micro>(result.slowest_read).count());
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+    const auto seconds = argc > 1 ? std::max(1, std::atoi(argv[1])) : 1;
+    const std::chrono::milliseconds duration{seconds * 1000};
+
+    const auto hardware = std::max(2U, std::thread::hardware_concurrency());
+    std::vector<std::size_t> reader_counts{1, 2, 4};
+    std::erase_if(reader_counts, [hardware](std::size_t count) { return count + 1 > hardware; });
+    if (reader_counts.empty()) {
+        reader_counts.push_back(1);
+    }
+
+    std::printf("%-10s %7s %14s %14s %14s\n", "store", "readers", "writes/s", "reads/s", "slowest read us");
+    for (const auto readers : reader_counts) {
+        {
+            engine::store::Store<ChatState, ChatAction> store{initial_state(), game::state::reduce_chat_state};
+            const auto result = run(
+                readers,
+                duration,
+                [&store] { return game::state::selected_history(*store.snapshot()).size(); },
+                [&store](const ChatAction& action) { store.dispatch(action); }
+            );
+            print_row("snapshot", readers, duration, result);
+        }
+        {
+            LockedStore store{initial_state(), game::state::reduce_chat_state};
+            const auto result = run(
+                readers,
+                duration,
+                [&store] { return game::state::selected_history(store.state()).size(); },
+                [&store](const ChatAction& action) { store.dispatch(action); }
+            );
+            print_row("mutex", readers, duration, result);
+        }
+    }
+
+    return 0;
+}
@@ -4,7 +4,7 @@
 
 namespace engine::backend {
 
-void Backend::emit(engine::events::EventId id, engine::events::EventPayload payload) {
+void Backend::emit(engine::events::EventId id, engine::events::EventPayload payload, AccountId account) {
     if (events_ == nullptr) {
         return;
     }
@@ -12,10 +12,30 @@ void Backend::emit(engine::events::EventId id, engine::events::EventPayload payl
     engine::events::Event event{};
     event.id = id;
     event.source = source_;
+    event.account = account;
     event.payload = std::move(payload);
+
+    if (batching_) {
+        batch_.push_back(std::move(event));
+        return;
+    }
     events_->emit(std::move(event));
 }
 
+void Backend::begin_emit_batch() {
+    batching_ = true;
+}
+
+void Backend::flush_emit_batch() {
+    batching_ = false;
+    if (events_ == nullptr || batch_.empty()) {
+        return;
+    }
+
+    events_->emit_batch(batch_);
+    batch_.clear();
+}
+
 }  // namespace engine::backend
 
 
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <chrono>
 #include <expected>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "engine/backend/backend_types.hpp"
+#include "engine/backend/request_tracker.hpp"
 #include "engine/events/event.hpp"
 #include "engine/events/event_service.hpp"
 
@@ -19,23 +22,39 @@ public:
     auto operator=(Backend&&) -> Backend& = delete;
     virtual ~Backend() = default;
 
+    // start, stop, poll and the requests are only ever called from the NetworkManager
+    // reactor thread; wake() is the one entry point that may be called from anywhere
     virtual auto start() -> std::expected<void, std::string> = 0;
     virtual void stop() = 0;
-    virtual void request_chats(std::int32_t limit) = 0;
-    virtual void request_history(ChatId chat_id, std::int32_t limit) = 0;
-    virtual void send_message(ChatId chat_id, std::string_view text) = 0;
+    // waits up to `timeout` for backend I/O and handles everything that arrived
+    virtual void poll(std::chrono::milliseconds timeout) = 0;
+    // makes the current or next poll() return promptly
+    virtual void wake() = 0;
+    // accounts are numbered 0..account_count()-1; requests for unknown accounts are ignored
+    [[nodiscard]] virtual auto account_count() const -> std::size_t { return 1; }
+    // per-function latency and timeout numbers; safe to call from any thread
+    [[nodiscard]] virtual auto request_stats() const -> std::vector<RequestStats> { return {}; }
+    virtual void request_chats(AccountId account, std::int32_t limit) = 0;
+    // `before` 0 pages down from the newest message, otherwise from just below that id
+    virtual void request_history(AccountId account, ChatId chat_id, std::int32_t limit, MessageId before) = 0;
+    virtual void send_message(AccountId account, ChatId chat_id, std::string_view text) = 0;
 
 protected:
-    void emit(engine::events::EventId id, engine::events::EventPayload payload);
+    void emit(engine::events::EventId id, engine::events::EventPayload payload, AccountId account = 0);
+    // events emitted between these two calls reach the EventService in one emit_batch()
+    void begin_emit_batch();
+    void flush_emit_batch();
 
 private:
     engine::events::EventService* events_{nullptr};
-    std::string source_{};
+    engine::events::SourceId source_{0};
+    bool batching_{false};
+    std::vector<engine::events::Event> batch_{};
 };
 
 inline Backend::Backend(engine::events::EventService& events, std::string source)
     : events_{&events},
-      source_{std::move(source)} {}
+      source_{engine::events::EventSources::intern(source)} {}
 
 }  // namespace engine::backend
 
@@ -1,77 +1,81 @@
 #include "engine/backend/backend_event_handlers.hpp"
 
 #include <algorithm>
-#include <iostream>
 #include <utility>
+#include <variant>
 
 namespace engine::backend {
 
-auto register_event_handlers(engine::events::EventService& events,
-                             game::state::ChatStore& chat_store,
-                             engine::backend::NetworkManager& network_manager)
+void PendingChatActions::push(game::state::ChatAction action) {
+    actions.push_back(std::move(action));
+}
+
+void PendingChatActions::push_message(const engine::backend::Message& message) {
+    if (!actions.empty()) {
+        if (auto* batch = std::get_if<game::state::AppendMessages>(&actions.back())) {
+            batch->messages.push_back(message);
+            return;
+        }
+    }
+    actions.push_back(game::state::AppendMessages{{message}});
+}
+
+auto register_event_handlers(engine::events::EventService& events, engine::cache::ChatCache* chat_cache)
     -> EventHandlerSubscriptions {
     EventHandlerSubscriptions holder{};
+    // heap-owned so the holder can move while the handlers keep pointing at the list
+    auto* pending = holder.pending.get();
 
-    holder.subs.push_back(events.subscribe(
-        engine::events::EventId::BackendStatus,
-        [&chat_store, &network_manager](const engine::events::Event& event) {
-            const auto* payload = std::get_if<engine::backend::BackendStatus>(&event.payload);
-            if (payload == nullptr) {
-                return;
-            }
-            chat_store.dispatch(game::state::SetBackendStatus{*payload});
+    holder.subs.push_back(events.subscribe<engine::backend::BackendStatus>(
+        [pending](const engine::events::Event& event, const engine::backend::BackendStatus& status) {
+            pending->push(game::state::SetBackendStatus{status, event.sequence});
         }
     ));
 
-    holder.subs.push_back(events.subscribe(
-        engine::events::EventId::BackendChatList,
-        [&chat_store](const engine::events::Event& event) {
-            const auto* payload = std::get_if<std::vector<engine::backend::ChatSummary>>(&event.payload);
-            if (payload == nullptr) {
-                return;
-            }
-            const auto take_count = std::min<std::size_t>(5, payload->size());
-            std::vector<engine::backend::ChatSummary> limited(payload->begin(), payload->begin() + take_count);
-            chat_store.dispatch(game::state::SetChats{std::move(limited)});
-
-            const auto snapshot = chat_store.state();
-            std::cout << "BackendChatList event received (" << snapshot.chats.size() << " entries):" << std::endl;
-            for (const auto& chat : snapshot.chats) {
-                std::cout << "  chat_id=" << chat.id << " title=\"" << chat.title << "\"" << std::endl;
+    holder.subs.push_back(events.subscribe<std::vector<engine::backend::ChatSummary>>(
+        [pending, chat_cache](const engine::events::Event& event,
+                              const std::vector<engine::backend::ChatSummary>& chats) {
+            if (chat_cache != nullptr) {
+                chat_cache->store_chats(chats);
             }
+            const auto take_count = std::min<std::size_t>(game::state::kVisibleChatCount, chats.size());
+            std::vector<engine::backend::ChatSummary> limited(chats.begin(), chats.begin() + take_count);
+            pending->push(game::state::SetChats{event.account, std::move(limited), event.sequence});
         }
     ));
 
-    holder.subs.push_back(events.subscribe(
-        engine::events::EventId::BackendChatHistory,
-        [&chat_store](const engine::events::Event& event) {
-            const auto* history = std::get_if<engine::backend::ChatHistory>(&event.payload);
-            if (history == nullptr) {
+    holder.subs.push_back(events.subscribe<engine::backend::ChatHistoryPtr>(
+        [pending, chat_cache](const engine::events::Event& event, const engine::backend::ChatHistoryPtr& payload) {
+            if (payload == nullptr) {
                 return;
             }
-            chat_store.dispatch(game::state::SetChatHistory{*history});
-            std::cout << "Chat history for chat " << history->chat_id << " ("
-                      << history->messages.size() << " messages):" << std::endl;
-            for (const auto& message : history->messages) {
-                std::cout << "[" << message.sender << "] " << message.text << std::endl;
+            if (chat_cache != nullptr) {
+                chat_cache->store_messages(payload->messages);
             }
+            pending->push(game::state::SetChatHistory{payload, event.sequence});
         }
     ));
 
-    holder.subs.push_back(events.subscribe(
-        engine::events::EventId::BackendNewMessage,
-        [&chat_store](const engine::events::Event& event) {
-            const auto* message = std::get_if<engine::backend::Message>(&event.payload);
-            if (message == nullptr) {
-                return;
+    holder.subs.push_back(events.subscribe<engine::backend::Message>(
+        [pending, chat_cache](const engine::events::Event&, const engine::backend::Message& message) {
+            if (chat_cache != nullptr) {
+                chat_cache->store_message(message);
             }
-            chat_store.dispatch(game::state::AppendMessage{*message});
+            pending->push_message(message);
         }
     ));
 
     return holder;
 }
 
+void flush_event_handlers(EventHandlerSubscriptions& handlers, game::state::ChatStore& chat_store) {
+    if (handlers.pending == nullptr || handlers.pending->actions.empty()) {
+        return;
+    }
+    chat_store.dispatch_batch(handlers.pending->actions);
+    handlers.pending->actions.clear();
+}
+
 }  // namespace engine::backend
 
 
@@ -1,22 +1,35 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 
-#include "engine/backend/network_manager.hpp"
+#include "engine/cache/chat_cache.hpp"
 #include "engine/events/event_service.hpp"
 #include "game/state/chat_store.hpp"
 
 namespace engine::backend {
 
+// store actions produced by one dispatch pass; consecutive new messages share one
+// AppendMessages
+struct PendingChatActions {
+    std::vector<game::state::ChatAction> actions{};
+
+    void push(game::state::ChatAction action);
+    void push_message(const engine::backend::Message& message);
+};
+
 struct EventHandlerSubscriptions {
     std::vector<engine::events::EventService::Subscription> subs{};
+    std::shared_ptr<PendingChatActions> pending{std::make_shared<PendingChatActions>()};
 };
 
-auto register_event_handlers(engine::events::EventService& events,
-                             game::state::ChatStore& chat_store,
-                             engine::backend::NetworkManager& network_manager)
+auto register_event_handlers(engine::events::EventService& events, engine::cache::ChatCache* chat_cache)
     -> EventHandlerSubscriptions;
 
+// hands everything the handlers collected since the last call to the store as one batch:
+// one reducer pass, one notification
+void flush_event_handlers(EventHandlerSubscriptions& handlers, game::state::ChatStore& chat_store);
+
 }  // namespace engine::backend
 
 
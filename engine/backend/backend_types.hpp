@@ -1,39 +1,102 @@
 #pragma once
 
+#include <compare>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <string>
 #include <variant>
 #include <vector>
 
+#include "engine/backend/message_text.hpp"
+
 namespace engine::backend {
 
+using AccountId = std::uint32_t;
 using ChatId = std::int64_t;
 using MessageId = std::int64_t;
 using Timestamp = std::int64_t;
 
-struct ChatSummary {
-    ChatId id{0};
-    std::string title{};
+// chat ids are only unique within one account
+struct ChatKey {
+    AccountId account{0};
+    ChatId chat_id{0};
+
+    friend auto operator==(const ChatKey&, const ChatKey&) -> bool = default;
+    friend auto operator<=>(const ChatKey&, const ChatKey&) = default;
+};
+
+struct ChatKeyHash {
+    auto operator()(const ChatKey& key) const noexcept -> std::size_t {
+        return std::hash<std::int64_t>{}(key.chat_id) ^ (static_cast<std::size_t>(key.account) << 1U);
+    }
+};
+
+enum class SenderKind : std::uint8_t { User, Chat };
+
+// a kind read back from disk; nullopt for values no SenderKind has
+inline auto sender_kind_from(std::uint32_t raw) -> std::optional<SenderKind> {
+    if (raw > static_cast<std::uint32_t>(SenderKind::Chat)) {
+        return std::nullopt;
+    }
+    return static_cast<SenderKind>(raw);
+}
+
+// display names live in SenderNames, keyed by this
+struct SenderId {
+    SenderKind kind{SenderKind::User};
+    std::int64_t id{0};
+
+    friend auto operator==(const SenderId&, const SenderId&) -> bool = default;
+};
+
+struct SenderIdHash {
+    auto operator()(const SenderId& sender) const noexcept -> std::size_t {
+        return std::hash<std::int64_t>{}(sender.id) ^ static_cast<std::size_t>(sender.kind);
+    }
 };
 
 struct Message {
     MessageId id{0};
     ChatId chat_id{0};
-    std::string sender{};
-    std::string text{};
+    AccountId account{0};
+    SenderId sender{};
+    MessageText text{};
     Timestamp timestamp{0};
 };
 
+struct ChatSummary {
+    ChatId id{0};
+    AccountId account{0};
+    std::string title{};
+    std::int64_t order{0};  // position in the main chat list, higher first; 0 when not listed
+    std::int32_t unread_count{0};
+    std::optional<Message> last_message{};
+};
+
+// history can arrive as a stream of chunks; the first chunk of a load starts it, later ones
+// continue it. A load either pages down from the newest message or, with `before` set, from
+// just below that id to fill in an older range.
 struct ChatHistory {
     ChatId chat_id{0};
+    AccountId account{0};
     std::vector<Message> messages{};
+    MessageId before{0};
+    bool append{false};
+    bool complete{true};
 };
 
+// histories are built once on the backend thread and then only shared, never copied
+using ChatHistoryPtr = std::shared_ptr<const ChatHistory>;
+
 enum class BackendStatusKind { Connecting, Ready, Error, Stopped };
 
 struct BackendStatus {
     BackendStatusKind kind{BackendStatusKind::Connecting};
     std::string detail{};
+    AccountId account{0};
 };
 
 enum class BackendEventType { Status, ChatList, ChatHistory, NewMessage };
@@ -0,0 +1,243 @@
+#include "engine/backend/loopback/loopback_backend.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <utility>
+
+namespace engine::backend::loopback {
+
+namespace {
+
+constexpr ChatId kChatIdBase = 100000;
+constexpr Timestamp kBaseTimestamp = 1700000000;
+constexpr Timestamp kMessageInterval = 15;
+constexpr std::uint64_t kSenderCount = 8;
+constexpr auto kGeneratorTick = std::chrono::milliseconds{10};
+
+constexpr std::array<std::string_view, 16> kWords = {
+    "lounge", "hello", "queue", "frame", "render", "message", "chat", "history",
+    "burst", "latency", "store", "event", "socket", "reply", "update", "window"
+};
+
+// splitmix64 finalizer; used instead of <random> distributions because their output is
+// implementation-defined and would break reproducibility across standard libraries
+auto mix(std::uint64_t value) -> std::uint64_t {
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27U)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31U);
+}
+
+auto message_key(std::uint64_t seed, ChatId chat_id, MessageId message_id) -> std::uint64_t {
+    return mix(seed ^ mix(static_cast<std::uint64_t>(chat_id) ^ mix(static_cast<std::uint64_t>(message_id))));
+}
+
+}  // namespace
+
+LoopbackBackend::LoopbackBackend(engine::events::EventService& events,
+                                 std::string source,
+                                 engine::config::LoopbackSettings settings)
+    : Backend(events, std::move(source)),
+      settings_{settings},
+      live_rng_{settings.seed} {}
+
+LoopbackBackend::~LoopbackBackend() {
+    stop();
+}
+
+auto LoopbackBackend::start() -> std::expected<void, std::string> {
+    emit(engine::events::EventId::BackendStatus,
+         BackendStatus{BackendStatusKind::Connecting, "Starting loopback backend"});
+
+    chats_.clear();
+    chats_.reserve(static_cast<std::size_t>(settings_.chat_count));
+    for (int i = 0; i < settings_.chat_count; ++i) {
+        SyntheticChat chat{};
+        chat.id = kChatIdBase + i;
+        chat.title = "Loopback Chat " + std::to_string(i + 1);
+        chat.next_message_id = static_cast<MessageId>(settings_.history_size) + 1;
+        chats_.push_back(std::move(chat));
+    }
+
+    started_ = std::chrono::steady_clock::now();
+    emitted_ = 0;
+    running_ = true;
+
+    emit(engine::events::EventId::BackendStatus,
+         BackendStatus{BackendStatusKind::Ready, "Loopback ready"});
+
+    return {};
+}
+
+void LoopbackBackend::stop() {
+    if (!running_) {
+        return;
+    }
+
+    running_ = false;
+
+    emit(engine::events::EventId::BackendStatus,
+         BackendStatus{BackendStatusKind::Stopped, "Backend stopped"});
+}
+
+void LoopbackBackend::request_chats(AccountId account, std::int32_t limit) {
+    if (account != 0) {
+        return;
+    }
+
+    const auto count = std::min<std::size_t>(chats_.size(), static_cast<std::size_t>(std::max(limit, 0)));
+
+    std::vector<ChatSummary> summaries{};
+    summaries.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        auto& chat = chats_[i];
+        ChatSummary summary{};
+        summary.id = chat.id;
+        summary.title = chat.title;
+        summary.order = static_cast<std::int64_t>(chats_.size() - i);
+        if (chat.next_message_id > 1) {
+            summary.last_message = make_message(chat, chat.next_message_id - 1, live_text_);
+        }
+        summaries.push_back(std::move(summary));
+    }
+
+    emit(engine::events::EventId::BackendChatList, std::move(summaries));
+}
+
+void LoopbackBackend::request_history(AccountId account, ChatId chat_id, std::int32_t limit, MessageId before) {
+    if (account != 0) {
+        return;
+    }
+
+    const std::int32_t clamped_limit = limit <= 0 ? 10 : limit;
+
+    auto* chat = find_chat(chat_id);
+    if (chat == nullptr) {
+        return;
+    }
+
+    ChatHistory history{};
+    history.chat_id = chat_id;
+    history.before = before;
+    TextArena arena{};
+
+    // newest first, matching the page order returned by getChatHistory
+    const MessageId first = before > 0 ? std::min(before, chat->next_message_id) : chat->next_message_id;
+    for (MessageId id = first - 1;
+         id > 0 && static_cast<std::int32_t>(history.messages.size()) < clamped_limit;
+         --id) {
+        history.messages.push_back(make_message(*chat, id, arena));
+    }
+
+    emit(engine::events::EventId::BackendChatHistory, std::make_shared<const ChatHistory>(std::move(history)));
+}
+
+void LoopbackBackend::send_message(AccountId account, ChatId chat_id, std::string_view text) {
+    if (account != 0) {
+        return;
+    }
+
+    auto* chat = find_chat(chat_id);
+    if (chat == nullptr) {
+        return;
+    }
+
+    Message message{};
+    message.id = chat->next_message_id++;
+    message.chat_id = chat_id;
+    message.sender = SenderId{SenderKind::User, 0};
+    message.text = live_text_.append(text);
+    message.timestamp = kBaseTimestamp + message.id * kMessageInterval;
+
+    emit(engine::events::EventId::BackendNewMessage, std::move(message));
+}
+
+void LoopbackBackend::poll(std::chrono::milliseconds timeout) {
+    // with a flood configured the generator tick bounds the wait, like a timerfd would
+    const auto wait = settings_.messages_per_second > 0 ? std::min(timeout, kGeneratorTick) : timeout;
+
+    {
+        std::unique_lock lock(wake_mutex_);
+        wake_cv_.wait_for(lock, wait, [this] { return wake_requested_; });
+        wake_requested_ = false;
+    }
+
+    if (running_) {
+        emit_due_messages();
+    }
+}
+
+void LoopbackBackend::wake() {
+    {
+        std::lock_guard lock(wake_mutex_);
+        wake_requested_ = true;
+    }
+    wake_cv_.notify_one();
+}
+
+void LoopbackBackend::emit_due_messages() {
+    if (settings_.messages_per_second <= 0) {
+        return;
+    }
+
+    // catch up on everything due since start so bursts are not flattened by poll jitter
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started_;
+    const auto due = static_cast<std::uint64_t>(elapsed.count() * settings_.messages_per_second);
+
+    for (; emitted_ < due; ++emitted_) {
+        emit_live_message();
+    }
+}
+
+void LoopbackBackend::emit_live_message() {
+    if (chats_.empty()) {
+        return;
+    }
+
+    auto& chat = chats_[live_rng_() % chats_.size()];
+    const auto message_id = chat.next_message_id++;
+    emit(engine::events::EventId::BackendNewMessage, make_message(chat, message_id, live_text_));
+}
+
+auto LoopbackBackend::find_chat(ChatId chat_id) -> SyntheticChat* {
+    const auto it = std::find_if(chats_.begin(), chats_.end(), [chat_id](const SyntheticChat& chat) {
+        return chat.id == chat_id;
+    });
+    return it != chats_.end() ? &*it : nullptr;
+}
+
+auto LoopbackBackend::make_message(const SyntheticChat& chat, MessageId message_id, TextArena& arena) -> Message {
+    const auto key = message_key(settings_.seed, chat.id, message_id);
+    make_text(key, text_scratch_);
+
+    Message message{};
+    message.id = message_id;
+    message.chat_id = chat.id;
+    message.sender = SenderId{SenderKind::User, static_cast<std::int64_t>(1 + key % kSenderCount)};
+    message.text = arena.append(text_scratch_);
+    message.timestamp = kBaseTimestamp + message_id * kMessageInterval;
+    return message;
+}
+
+void LoopbackBackend::make_text(std::uint64_t key, std::string& text) const {
+    const auto min_size = static_cast<std::uint64_t>(settings_.message_size_min);
+    const auto max_size = static_cast<std::uint64_t>(settings_.message_size_max);
+    const auto size = static_cast<std::size_t>(min_size + mix(key) % (max_size - min_size + 1));
+
+    text.clear();
+    text.reserve(size + kWords.size());
+
+    auto state = key;
+    while (text.size() < size) {
+        state = mix(state);
+        if (!text.empty()) {
+            text.push_back(' ');
+        }
+        text.append(kWords[state % kWords.size()]);
+    }
+    text.resize(size);
+}
+
+}  // namespace engine::backend::loopback
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "engine/backend/backend.hpp"
+#include "engine/config/config.hpp"
+
+namespace engine::backend::loopback {
+
+// Synthetic in-process backend used to load-test the event -> store -> UI path without a
+// Telegram account. Chats, history pages and the live message flood are all derived from
+// `settings.seed`, so two runs with the same config produce the same traffic.
+class LoopbackBackend : public Backend {
+public:
+    LoopbackBackend(engine::events::EventService& events,
+                    std::string source,
+                    engine::config::LoopbackSettings settings);
+    LoopbackBackend(const LoopbackBackend&) = delete;
+    auto operator=(const LoopbackBackend&) -> LoopbackBackend& = delete;
+    LoopbackBackend(LoopbackBackend&&) = delete;
+    auto operator=(LoopbackBackend&&) -> LoopbackBackend& = delete;
+    ~LoopbackBackend() override;
+
+    auto start() -> std::expected<void, std::string> override;
+    void stop() override;
+    void poll(std::chrono::milliseconds timeout) override;
+    void wake() override;
+    // single synthetic account; requests for any other account are ignored
+    void request_chats(AccountId account, std::int32_t limit) override;
+    void request_history(AccountId account, ChatId chat_id, std::int32_t limit, MessageId before) override;
+    void send_message(AccountId account, ChatId chat_id, std::string_view text) override;
+
+private:
+    struct SyntheticChat {
+        ChatId id{0};
+        std::string title{};
+        MessageId next_message_id{1};
+    };
+
+    void emit_due_messages();
+    void emit_live_message();
+
+    [[nodiscard]] auto find_chat(ChatId chat_id) -> SyntheticChat*;
+    [[nodiscard]] auto make_message(const SyntheticChat& chat, MessageId message_id, TextArena& arena) -> Message;
+    void make_text(std::uint64_t key, std::string& text) const;
+
+    engine::config::LoopbackSettings settings_{};
+    std::vector<SyntheticChat> chats_{};
+    std::mt19937_64 live_rng_{};
+    std::chrono::steady_clock::time_point started_{};
+    std::uint64_t emitted_{0};
+    std::string text_scratch_{};
+    // live messages and list previews; a history reply packs its text into its own arena
+    TextArena live_text_{};
+
+    std::atomic<bool> running_{false};
+    // the only state shared with other threads: wake() may be called from anywhere
+    std::mutex wake_mutex_{};
+    std::condition_variable wake_cv_{};
+    bool wake_requested_{false};
+};
+
+}  // namespace engine::backend::loopback
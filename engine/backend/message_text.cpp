@@ -0,0 +1,51 @@
+#include "engine/backend/message_text.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace engine::backend {
+
+namespace {
+
+// texts at least this large get an exact allocation instead of wasting a chunk's tail
+constexpr std::size_t kDedicatedThreshold = TextArena::kChunkSize / 4;
+
+}  // namespace
+
+auto MessageText::copy_of(std::string_view text) -> MessageText {
+    if (text.empty()) {
+        return {};
+    }
+    const auto size = static_cast<std::uint32_t>(std::min<std::size_t>(text.size(), UINT32_MAX));
+    std::shared_ptr<char[]> copy = std::make_shared_for_overwrite<char[]>(size);
+    std::memcpy(copy.get(), text.data(), size);
+    return MessageText{std::shared_ptr<const char>(copy, copy.get()), size};
+}
+
+auto TextArena::append(std::string_view text) -> MessageText {
+    if (text.empty()) {
+        return {};
+    }
+
+    const auto size = static_cast<std::uint32_t>(std::min<std::size_t>(text.size(), UINT32_MAX));
+
+    if (size >= kDedicatedThreshold) {
+        return MessageText::copy_of(text);
+    }
+
+    if (chunk_ == nullptr || capacity_ - used_ < size) {
+        capacity_ = std::max<std::size_t>(next_chunk_, size);
+        chunk_ = std::make_shared_for_overwrite<char[]>(capacity_);
+        used_ = 0;
+        next_chunk_ = std::min(capacity_ * 2, kChunkSize);
+    }
+
+    // bytes before used_ are never written again, so readers on other threads are safe
+    char* data = chunk_.get() + used_;
+    std::memcpy(data, text.data(), size);
+    used_ += size;
+
+    return MessageText{std::shared_ptr<const char>(chunk_, data), size};
+}
+
+}  // namespace engine::backend
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+
+namespace engine::backend {
+
+// Immutable handle to message text stored in a TextArena chunk. Copies share the chunk
+// (one refcount bump); the chunk is freed once no message points into it anymore.
+class MessageText {
+public:
+    MessageText() = default;
+
+    // standalone copy for text that does not come from a backend arena
+    [[nodiscard]] static auto copy_of(std::string_view text) -> MessageText;
+
+    [[nodiscard]] auto view() const noexcept -> std::string_view { return {data_.get(), size_}; }
+    [[nodiscard]] auto size() const noexcept -> std::size_t { return size_; }
+    [[nodiscard]] auto empty() const noexcept -> bool { return size_ == 0; }
+
+    friend auto operator==(const MessageText& lhs, const MessageText& rhs) -> bool {
+        return lhs.view() == rhs.view();
+    }
+
+private:
+    friend class TextArena;
+
+    MessageText(std::shared_ptr<const char> data, std::uint32_t size)
+        : data_{std::move(data)},
+          size_{size} {}
+
+    // aliases the owning chunk, so the handle is one pointer pair plus the length
+    std::shared_ptr<const char> data_{};
+    std::uint32_t size_{0};
+};
+
+// Bump allocator for message text. Each history load appends into its own arena so the
+// texts of one page share a few chunk allocations instead of one heap string each.
+// Chunks start at kFirstChunkSize and double up to kChunkSize, so an arena that only sees
+// a few short texts stays small. Not thread-safe; handles it returns may be shared freely.
+class TextArena {
+public:
+    static constexpr std::size_t kFirstChunkSize = 256;
+    static constexpr std::size_t kChunkSize = 16 * 1024;
+
+    [[nodiscard]] auto append(std::string_view text) -> MessageText;
+
+private:
+    std::shared_ptr<char[]> chunk_{};
+    std::size_t capacity_{0};
+    std::size_t used_{0};
+    std::size_t next_chunk_{kFirstChunkSize};
+};
+
+}  // namespace engine::backend
@@ -1,14 +1,16 @@
 #include "engine/backend/network_manager.hpp"
 
+#include <algorithm>
 #include <utility>
 
 namespace engine::backend {
 
-auto NetworkManager::make_shutdown_command() -> NetworkManager::Command {
-    NetworkManager::Command cmd{};
-    cmd.type = NetworkManager::CommandType::Shutdown;
-    return cmd;
-}
+namespace {
+
+// upper bound for an idle poll; new commands and shutdown wake the backend immediately
+constexpr std::chrono::milliseconds kIdlePollTimeout{1000};
+
+}  // namespace
 
 NetworkManager::NetworkManager(std::unique_ptr<Backend> backend)
     : backend_{std::move(backend)} {}
@@ -28,7 +30,7 @@ auto NetworkManager::start() -> std::expected<void, std::string> {
 
     running_ = true;
     started_ = true;
-    worker_ = std::thread(&NetworkManager::worker_loop, this);
+    reactor_ = std::thread(&NetworkManager::reactor_loop, this);
 
     return {};
 }
@@ -39,37 +41,69 @@ void NetworkManager::stop() {
     }
 
     running_ = false;
-    {
-        std::lock_guard lock(mutex_);
-        commands_.push_back(make_shutdown_command());
-    }
-    cv_.notify_all();
+    backend_->wake();
 
-    if (worker_.joinable()) {
-        worker_.join();
+    if (reactor_.joinable()) {
+        reactor_.join();
     }
 }
 
-void NetworkManager::request_chats(std::int32_t limit) {
-    enqueue(Command{.type = CommandType::RequestChats, .limit = limit});
+// fixed for the backend's lifetime, so safe to read from any thread
+auto NetworkManager::account_count() const -> std::size_t {
+    return backend_->account_count();
 }
 
-void NetworkManager::request_history(ChatId chat_id, std::int32_t limit) {
+auto NetworkManager::request_stats() const -> std::vector<RequestStats> {
+    return backend_->request_stats();
+}
+
+void NetworkManager::request_chats(AccountId account, std::int32_t limit, RequestPriority priority) {
+    enqueue(Command{
+        .type = CommandType::RequestChats,
+        .priority = priority,
+        .account = account,
+        .limit = limit
+    });
+}
+
+void NetworkManager::request_history(AccountId account,
+                                     ChatId chat_id,
+                                     std::int32_t limit,
+                                     MessageId before,
+                                     RequestPriority priority) {
     enqueue(Command{
         .type = CommandType::RequestHistory,
+        .priority = priority,
+        .account = account,
         .chat_id = chat_id,
-        .limit = limit
+        .limit = limit,
+        .before = before
     });
 }
 
-void NetworkManager::send_message(ChatId chat_id, std::string_view text) {
+void NetworkManager::send_message(AccountId account, ChatId chat_id, std::string_view text) {
     enqueue(Command{
         .type = CommandType::SendMessage,
+        .priority = RequestPriority::Interactive,
+        .account = account,
         .chat_id = chat_id,
         .text = std::string{text}
     });
 }
 
+auto NetworkManager::is_same_request(const Command& lhs, const Command& rhs) -> bool {
+    if (lhs.type != rhs.type || lhs.account != rhs.account) {
+        return false;
+    }
+
+    if (lhs.type == CommandType::RequestChats) {
+        return true;
+    }
+
+    // a fetch of an older range is a different request from the newest page
+    return lhs.type == CommandType::RequestHistory && lhs.chat_id == rhs.chat_id && lhs.before == rhs.before;
+}
+
 void NetworkManager::enqueue(Command cmd) {
     if (!running_) {
         return;
@@ -77,26 +111,71 @@ void NetworkManager::enqueue(Command cmd) {
 
     {
         std::lock_guard lock(mutex_);
-        commands_.push_back(std::move(cmd));
+        if (!coalesce(cmd)) {
+            lanes_[static_cast<std::size_t>(cmd.priority)].push_back(std::move(cmd));
+        }
     }
 
-    cv_.notify_one();
+    backend_->wake();
 }
 
-auto NetworkManager::dequeue() -> Command {
-    std::unique_lock lock(mutex_);
-    cv_.wait(lock, [this] { return !commands_.empty() || !running_; });
+// Folds a fetch into an equivalent pending one. The merged request keeps the larger limit
+// and the more urgent lane; a pending entry in a less urgent lane is dropped and re-queued
+// at the back of the new lane. Returns true when nothing is left to enqueue.
+auto NetworkManager::coalesce(Command& cmd) -> bool {
+    if (cmd.type == CommandType::SendMessage) {
+        return false;
+    }
+
+    for (std::size_t lane_index = 0; lane_index < kLaneCount; ++lane_index) {
+        auto& lane = lanes_[lane_index];
+        const auto it = std::find_if(lane.begin(), lane.end(), [&cmd](const Command& pending) {
+            return is_same_request(pending, cmd);
+        });
+        if (it == lane.end()) {
+            continue;
+        }
+
+        if (static_cast<std::size_t>(cmd.priority) >= lane_index) {
+            it->limit = std::max(it->limit, cmd.limit);
+            return true;
+        }
 
-    if (commands_.empty()) {
-        return make_shutdown_command();
+        cmd.limit = std::max(it->limit, cmd.limit);
+        lane.erase(it);
+        return false;
     }
 
-    auto cmd = std::move(commands_.front());
-    commands_.pop_front();
-    return cmd;
+    return false;
+}
+
+auto NetworkManager::take_next(Command& out) -> bool {
+    std::lock_guard lock(mutex_);
+    for (auto& lane : lanes_) {
+        if (!lane.empty()) {
+            out = std::move(lane.front());
+            lane.pop_front();
+            return true;
+        }
+    }
+    return false;
 }
 
-void NetworkManager::worker_loop() {
+void NetworkManager::execute(const Command& cmd) {
+    switch (cmd.type) {
+        case CommandType::RequestChats:
+            backend_->request_chats(cmd.account, cmd.limit);
+            break;
+        case CommandType::RequestHistory:
+            backend_->request_history(cmd.account, cmd.chat_id, cmd.limit, cmd.before);
+            break;
+        case CommandType::SendMessage:
+            backend_->send_message(cmd.account, cmd.chat_id, cmd.text);
+            break;
+    }
+}
+
+void NetworkManager::reactor_loop() {
     const auto start_result = backend_->start();
     if (!start_result.has_value()) {
         running_ = false;
@@ -104,26 +183,17 @@ void NetworkManager::worker_loop() {
     }
 
     while (running_) {
-        const auto cmd = dequeue();
-
-        if (cmd.type == CommandType::Shutdown) {
-            break;
-        }
-
-        if (cmd.type == CommandType::RequestChats) {
-            backend_->request_chats(cmd.limit);
+        // one command per turn keeps the lane order authoritative: anything more urgent
+        // that arrives while the backend is busy is picked up next
+        Command cmd{};
+        if (take_next(cmd)) {
+            execute(cmd);
+            backend_->poll(std::chrono::milliseconds{0});
             continue;
         }
 
-        if (cmd.type == CommandType::RequestHistory) {
-            backend_->request_history(cmd.chat_id, cmd.limit);
-            continue;
-        }
-
-        if (cmd.type == CommandType::SendMessage) {
-            backend_->send_message(cmd.chat_id, cmd.text);
-            continue;
-        }
+        // wake() is sticky, so a command enqueued after take_next still cuts this short
+        backend_->poll(kIdlePollTimeout);
     }
 
     backend_->stop();
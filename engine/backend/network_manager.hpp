@@ -1,19 +1,23 @@
 #pragma once
 
+#include <array>
 #include <atomic>
-#include <condition_variable>
 #include <deque>
 #include <expected>
 #include <mutex>
 #include <string>
 #include <string_view>
 #include <thread>
+#include <vector>
 
 #include "engine/backend/backend.hpp"
 #include "engine/backend/backend_types.hpp"
 
 namespace engine::backend {
 
+// Lanes are drained strictly in order, so a send never waits behind queued fetches.
+enum class RequestPriority : std::uint8_t { Interactive = 0, Foreground = 1, Background = 2 };
+
 class NetworkManager {
 public:
     explicit NetworkManager(std::unique_ptr<Backend> backend);
@@ -26,30 +30,47 @@ public:
     auto start() -> std::expected<void, std::string>;
     void stop();
 
-    void request_chats(std::int32_t limit);
-    void request_history(ChatId chat_id, std::int32_t limit);
-    void send_message(ChatId chat_id, std::string_view text);
+    [[nodiscard]] auto account_count() const -> std::size_t;
+    [[nodiscard]] auto request_stats() const -> std::vector<RequestStats>;
+
+    void request_chats(AccountId account,
+                       std::int32_t limit,
+                       RequestPriority priority = RequestPriority::Foreground);
+    // `before` 0 fetches the newest messages, otherwise the ones just below that id
+    void request_history(AccountId account,
+                         ChatId chat_id,
+                         std::int32_t limit,
+                         MessageId before = 0,
+                         RequestPriority priority = RequestPriority::Foreground);
+    void send_message(AccountId account, ChatId chat_id, std::string_view text);
 
 private:
-    enum class CommandType { RequestChats, RequestHistory, SendMessage, Shutdown };
+    enum class CommandType { RequestChats, RequestHistory, SendMessage };
 
     struct Command {
         CommandType type{CommandType::RequestChats};
+        RequestPriority priority{RequestPriority::Foreground};
+        AccountId account{0};
         ChatId chat_id{0};
         std::int32_t limit{0};
+        MessageId before{0};
         std::string text{};
     };
 
-    [[nodiscard]] static auto make_shutdown_command() -> Command;
-    void worker_loop();
+    static constexpr std::size_t kLaneCount = 3;
+
+    [[nodiscard]] static auto is_same_request(const Command& lhs, const Command& rhs) -> bool;
+    // single reactor: drains queued commands, then lets the backend wait for I/O
+    void reactor_loop();
     void enqueue(Command cmd);
-    auto dequeue() -> Command;
+    auto coalesce(Command& cmd) -> bool;
+    auto take_next(Command& out) -> bool;
+    void execute(const Command& cmd);
 
     std::unique_ptr<Backend> backend_{};
-    std::thread worker_{};
+    std::thread reactor_{};
     std::mutex mutex_{};
-    std::condition_variable cv_{};
-    std::deque<Command> commands_{};
+    std::array<std::deque<Command>, kLaneCount> lanes_{};
     std::atomic<bool> running_{false};
     std::atomic<bool> started_{false};
 };
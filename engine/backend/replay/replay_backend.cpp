@@ -0,0 +1,129 @@
+#include "engine/backend/replay/replay_backend.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace engine::backend::replay {
+
+namespace {
+
+// bounds one poll when replaying as fast as possible so stop() and wake() stay responsive
+constexpr std::size_t kMaxEventsPerPoll = 256;
+
+}  // namespace
+
+ReplayBackend::ReplayBackend(engine::events::EventService& events,
+                             std::string source,
+                             engine::config::ReplaySettings settings)
+    : Backend(events, std::move(source)),
+      settings_{std::move(settings)} {}
+
+ReplayBackend::~ReplayBackend() {
+    stop();
+}
+
+auto ReplayBackend::start() -> std::expected<void, std::string> {
+    auto recording = engine::events::load_recording(settings_.path);
+    if (!recording.has_value()) {
+        return std::unexpected(recording.error());
+    }
+
+    events_ = std::move(recording.value());
+    next_event_ = 0;
+    account_count_ = 1;
+    for (const auto& event : events_) {
+        account_count_ = std::max<std::size_t>(account_count_, static_cast<std::size_t>(event.account) + 1);
+    }
+
+    started_ = std::chrono::steady_clock::now();
+    running_ = true;
+    return {};
+}
+
+void ReplayBackend::stop() {
+    if (!running_) {
+        return;
+    }
+
+    running_ = false;
+    for (std::size_t account = 0; account < account_count_; ++account) {
+        const auto id = static_cast<AccountId>(account);
+        emit(engine::events::EventId::BackendStatus,
+             BackendStatus{BackendStatusKind::Stopped, "Backend stopped", id},
+             id);
+    }
+}
+
+void ReplayBackend::poll(std::chrono::milliseconds timeout) {
+    auto wait = std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+    if (running_ && next_event_ < events_.size()) {
+        wait = std::clamp<std::chrono::steady_clock::duration>(
+            due_at(events_[next_event_]) - std::chrono::steady_clock::now(),
+            std::chrono::steady_clock::duration::zero(),
+            wait
+        );
+    }
+
+    {
+        std::unique_lock lock(wake_mutex_);
+        wake_cv_.wait_for(lock, wait, [this] { return wake_requested_; });
+        wake_requested_ = false;
+    }
+
+    if (running_) {
+        emit_due_events();
+    }
+}
+
+void ReplayBackend::wake() {
+    {
+        std::lock_guard lock(wake_mutex_);
+        wake_requested_ = true;
+    }
+    wake_cv_.notify_one();
+}
+
+auto ReplayBackend::account_count() const -> std::size_t {
+    return account_count_;
+}
+
+void ReplayBackend::request_chats(AccountId, std::int32_t) {}
+
+void ReplayBackend::request_history(AccountId, ChatId, std::int32_t, MessageId) {}
+
+void ReplayBackend::send_message(AccountId, ChatId, std::string_view) {}
+
+auto ReplayBackend::due_at(const engine::events::RecordedEvent& event) const
+    -> std::chrono::steady_clock::time_point {
+    if (settings_.speed <= 0.0) {
+        return started_;
+    }
+
+    const auto offset = std::max(event.offset, std::chrono::microseconds::zero());
+    const std::chrono::duration<double, std::micro> scaled{static_cast<double>(offset.count()) / settings_.speed};
+    return started_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(scaled);
+}
+
+void ReplayBackend::emit_due_events() {
+    const auto now = std::chrono::steady_clock::now();
+    const auto limit = settings_.speed <= 0.0 ? kMaxEventsPerPoll : events_.size();
+
+    begin_emit_batch();
+    for (std::size_t emitted = 0; next_event_ < events_.size() && emitted < limit; ++next_event_, ++emitted) {
+        auto& event = events_[next_event_];
+        if (due_at(event) > now) {
+            break;
+        }
+
+        // the recorded shutdown would clear the replayed state; stop() reports our own
+        const auto* status = std::get_if<BackendStatus>(&event.payload);
+        if (status != nullptr && status->kind == BackendStatusKind::Stopped) {
+            continue;
+        }
+
+        emit(event.id, std::move(event.payload), event.account);
+    }
+    flush_emit_batch();
+}
+
+}  // namespace engine::backend::replay
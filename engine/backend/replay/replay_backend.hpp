@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "engine/backend/backend.hpp"
+#include "engine/config/config.hpp"
+#include "engine/events/event_recording.hpp"
+
+namespace engine::backend::replay {
+
+// Feeds a recorded session back through the EventService at its original pace, scaled by
+// `settings.speed`. Requests are ignored: everything the session received is already in
+// the recording, so two runs over the same file deliver the same events in the same order.
+class ReplayBackend : public Backend {
+public:
+    ReplayBackend(engine::events::EventService& events,
+                  std::string source,
+                  engine::config::ReplaySettings settings);
+    ReplayBackend(const ReplayBackend&) = delete;
+    auto operator=(const ReplayBackend&) -> ReplayBackend& = delete;
+    ReplayBackend(ReplayBackend&&) = delete;
+    auto operator=(ReplayBackend&&) -> ReplayBackend& = delete;
+    ~ReplayBackend() override;
+
+    auto start() -> std::expected<void, std::string> override;
+    void stop() override;
+    void poll(std::chrono::milliseconds timeout) override;
+    void wake() override;
+    // as many accounts as the recording mentions
+    [[nodiscard]] auto account_count() const -> std::size_t override;
+    void request_chats(AccountId account, std::int32_t limit) override;
+    void request_history(AccountId account, ChatId chat_id, std::int32_t limit, MessageId before) override;
+    void send_message(AccountId account, ChatId chat_id, std::string_view text) override;
+
+private:
+    [[nodiscard]] auto due_at(const engine::events::RecordedEvent& event) const
+        -> std::chrono::steady_clock::time_point;
+    void emit_due_events();
+
+    engine::config::ReplaySettings settings_{};
+    std::vector<engine::events::RecordedEvent> events_{};
+    std::size_t next_event_{0};
+    std::size_t account_count_{1};
+    std::chrono::steady_clock::time_point started_{};
+
+    std::atomic<bool> running_{false};
+    // the only state shared with other threads: wake() may be called from anywhere
+    std::mutex wake_mutex_{};
+    std::condition_variable wake_cv_{};
+    bool wake_requested_{false};
+};
+
+}  // namespace engine::backend::replay
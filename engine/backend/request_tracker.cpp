@@ -0,0 +1,153 @@
+#include "engine/backend/request_tracker.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace engine::backend {
+
+void LatencyHistogram::record(std::chrono::microseconds latency) {
+    const auto micros = static_cast<std::uint64_t>(std::max<std::int64_t>(latency.count(), 0));
+    ++buckets_[bucket_of(micros)];
+    ++count_;
+}
+
+auto LatencyHistogram::percentile(double fraction) const -> std::chrono::microseconds {
+    if (count_ == 0) {
+        return std::chrono::microseconds{0};
+    }
+
+    const auto rank = std::max<std::uint64_t>(
+        1,
+        static_cast<std::uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(count_)))
+    );
+
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < kBucketCount; ++bucket) {
+        seen += buckets_[bucket];
+        if (seen >= rank) {
+            return std::chrono::microseconds{static_cast<std::int64_t>(upper_bound_of(bucket))};
+        }
+    }
+    return std::chrono::microseconds{static_cast<std::int64_t>(upper_bound_of(kBucketCount - 1))};
+}
+
+// values below kSubBuckets map 1:1; above, each power of two [2^e, 2^(e+1)) is split into
+// kSubBuckets equal slices
+auto LatencyHistogram::bucket_of(std::uint64_t micros) -> std::size_t {
+    if (micros < kSubBuckets) {
+        return static_cast<std::size_t>(micros);
+    }
+
+    const auto exponent = static_cast<std::size_t>(std::bit_width(micros) - 1);
+    const auto slice = static_cast<std::size_t>(micros >> (exponent - 2)) - kSubBuckets;
+    const auto bucket = kSubBuckets + (exponent - 2) * kSubBuckets + slice;
+    return std::min(bucket, kBucketCount - 1);
+}
+
+auto LatencyHistogram::upper_bound_of(std::size_t bucket) -> std::uint64_t {
+    if (bucket < kSubBuckets) {
+        return bucket;
+    }
+
+    const auto exponent = (bucket - kSubBuckets) / kSubBuckets + 2;
+    const auto slice = (bucket - kSubBuckets) % kSubBuckets;
+    return ((kSubBuckets + slice + 1) << (exponent - 2)) - 1;
+}
+
+RequestTracker::RequestTracker(AccountId account)
+    : account_{account} {}
+
+void RequestTracker::begin(std::int64_t request_id,
+                           std::string_view function,
+                           std::optional<Clock::duration> timeout,
+                           RequestContext context) {
+    const auto now = Clock::now();
+
+    InFlight entry{};
+    entry.function = function;
+    entry.sent = now;
+    if (timeout.has_value()) {
+        entry.deadline = now + *timeout;
+    }
+    entry.context = context;
+    in_flight_[request_id] = entry;
+
+    std::lock_guard lock(stats_mutex_);
+    ++stats_[function].in_flight;
+}
+
+auto RequestTracker::complete(std::int64_t request_id) -> bool {
+    const auto it = in_flight_.find(request_id);
+    if (it == in_flight_.end()) {
+        return false;
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - it->second.sent);
+    const auto function = it->second.function;
+    in_flight_.erase(it);
+
+    std::lock_guard lock(stats_mutex_);
+    auto& stats = stats_[function];
+    --stats.in_flight;
+    stats.latency.record(elapsed);
+    return true;
+}
+
+auto RequestTracker::take_expired(Clock::time_point now) -> std::vector<Expired> {
+    std::vector<Expired> expired{};
+
+    for (auto it = in_flight_.begin(); it != in_flight_.end();) {
+        const auto& entry = it->second;
+        if (!entry.deadline.has_value() || *entry.deadline > now) {
+            ++it;
+            continue;
+        }
+
+        expired.push_back(Expired{it->first, entry.function, entry.context});
+        it = in_flight_.erase(it);
+    }
+
+    if (!expired.empty()) {
+        std::lock_guard lock(stats_mutex_);
+        for (const auto& request : expired) {
+            auto& stats = stats_[request.function];
+            --stats.in_flight;
+            ++stats.timed_out;
+        }
+    }
+
+    return expired;
+}
+
+auto RequestTracker::next_deadline() const -> std::optional<Clock::time_point> {
+    std::optional<Clock::time_point> earliest{};
+    for (const auto& [request_id, entry] : in_flight_) {
+        if (entry.deadline.has_value() && (!earliest.has_value() || *entry.deadline < *earliest)) {
+            earliest = entry.deadline;
+        }
+    }
+    return earliest;
+}
+
+auto RequestTracker::stats() const -> std::vector<RequestStats> {
+    std::lock_guard lock(stats_mutex_);
+
+    std::vector<RequestStats> result{};
+    result.reserve(stats_.size());
+    for (const auto& [function, stats] : stats_) {
+        result.push_back(RequestStats{
+            .account = account_,
+            .function = std::string{function},
+            .completed = stats.latency.count(),
+            .timed_out = stats.timed_out,
+            .in_flight = stats.in_flight,
+            .p50 = stats.latency.percentile(0.50),
+            .p95 = stats.latency.percentile(0.95),
+            .p99 = stats.latency.percentile(0.99)
+        });
+    }
+    return result;
+}
+
+}  // namespace engine::backend
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "engine/backend/backend_types.hpp"
+
+namespace engine::backend {
+
+// round-trip numbers for one backend function on one account
+struct RequestStats {
+    AccountId account{0};
+    std::string function{};
+    std::uint64_t completed{0};
+    std::uint64_t timed_out{0};
+    std::size_t in_flight{0};
+    std::chrono::microseconds p50{0};
+    std::chrono::microseconds p95{0};
+    std::chrono::microseconds p99{0};
+};
+
+// Log-linear latency histogram: four buckets per power of two, so a reported percentile
+// is at most ~25% above the true value. Percentiles report the bucket's upper bound.
+class LatencyHistogram {
+public:
+    void record(std::chrono::microseconds latency);
+    [[nodiscard]] auto count() const noexcept -> std::uint64_t { return count_; }
+    [[nodiscard]] auto percentile(double fraction) const -> std::chrono::microseconds;
+
+private:
+    static constexpr std::size_t kSubBuckets = 4;
+    static constexpr std::size_t kBucketCount = kSubBuckets + 40 * kSubBuckets;
+
+    [[nodiscard]] static auto bucket_of(std::uint64_t micros) -> std::size_t;
+    [[nodiscard]] static auto upper_bound_of(std::size_t bucket) -> std::uint64_t;
+
+    std::array<std::uint64_t, kBucketCount> buckets_{};
+    std::uint64_t count_{0};
+};
+
+// owner data carried through to expiry so a retry can rebuild the query
+struct RequestContext {
+    std::int64_t subject{0};
+    std::uint32_t attempt{0};
+};
+
+// In-flight request table for one client. Every query is recorded with its function,
+// send time and optional deadline; completions feed per-function latency histograms and
+// take_expired() hands back queries whose deadline passed so the owner can retry or
+// clean up. Everything except stats() must be called from the owning reactor thread.
+class RequestTracker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Expired {
+        std::int64_t request_id{0};
+        std::string_view function{};
+        RequestContext context{};
+    };
+
+    explicit RequestTracker(AccountId account);
+    RequestTracker(const RequestTracker&) = delete;
+    auto operator=(const RequestTracker&) -> RequestTracker& = delete;
+    RequestTracker(RequestTracker&&) = delete;
+    auto operator=(RequestTracker&&) -> RequestTracker& = delete;
+    ~RequestTracker() = default;
+
+    // `function` must outlive the tracker; callers pass string literals
+    void begin(std::int64_t request_id,
+               std::string_view function,
+               std::optional<Clock::duration> timeout,
+               RequestContext context = {});
+    // false for ids that were never tracked or already expired
+    auto complete(std::int64_t request_id) -> bool;
+    [[nodiscard]] auto take_expired(Clock::time_point now) -> std::vector<Expired>;
+    [[nodiscard]] auto next_deadline() const -> std::optional<Clock::time_point>;
+
+    // safe to call from any thread
+    [[nodiscard]] auto stats() const -> std::vector<RequestStats>;
+
+private:
+    struct InFlight {
+        std::string_view function{};
+        Clock::time_point sent{};
+        std::optional<Clock::time_point> deadline{};
+        RequestContext context{};
+    };
+
+    struct FunctionStats {
+        LatencyHistogram latency{};
+        std::uint64_t timed_out{0};
+        std::size_t in_flight{0};
+    };
+
+    AccountId account_{0};
+    std::unordered_map<std::int64_t, InFlight> in_flight_{};
+
+    mutable std::mutex stats_mutex_{};
+    std::map<std::string_view, FunctionStats, std::less<>> stats_{};
+};
+
+}  // namespace engine::backend
@@ -0,0 +1,60 @@
+#include "engine/backend/sender_names.hpp"
+
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace engine::backend {
+
+namespace {
+
+struct NameTable {
+    std::shared_mutex mutex{};
+    // node-based, so interned strings never move
+    std::unordered_set<std::string> pool{};
+    std::unordered_map<SenderId, std::string_view, SenderIdHash> names{};
+};
+
+auto table() -> NameTable& {
+    static NameTable names{};
+    return names;
+}
+
+auto fallback_label(SenderId sender) -> std::string {
+    const std::string_view prefix = sender.kind == SenderKind::Chat ? "chat:" : "user:";
+    return std::string{prefix} + std::to_string(sender.id);
+}
+
+// expects the unique lock to be held
+auto intern(NameTable& names, std::string value) -> std::string_view {
+    return *names.pool.insert(std::move(value)).first;
+}
+
+}  // namespace
+
+void SenderNames::assign(SenderId sender, std::string_view name) {
+    auto& names = table();
+    std::unique_lock lock(names.mutex);
+    names.names[sender] = intern(names, std::string{name});
+}
+
+auto SenderNames::lookup(SenderId sender) -> std::string_view {
+    auto& names = table();
+    {
+        std::shared_lock lock(names.mutex);
+        if (const auto it = names.names.find(sender); it != names.names.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock lock(names.mutex);
+    auto [it, inserted] = names.names.try_emplace(sender);
+    if (inserted) {
+        it->second = intern(names, fallback_label(sender));
+    }
+    return it->second;
+}
+
+}  // namespace engine::backend
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string_view>
+
+#include "engine/backend/backend_types.hpp"
+
+namespace engine::backend {
+
+// Process-wide intern table of sender display names. Backends assign names as they learn
+// them; lookups fall back to a "user:<id>" / "chat:<id>" label. Returned views stay valid
+// for the lifetime of the process, renaming a sender interns a new string.
+class SenderNames {
+public:
+    SenderNames() = delete;
+
+    static void assign(SenderId sender, std::string_view name);
+    [[nodiscard]] static auto lookup(SenderId sender) -> std::string_view;
+};
+
+}  // namespace engine::backend
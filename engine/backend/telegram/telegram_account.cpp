@@ -0,0 +1,944 @@
+#include "engine/backend/telegram/telegram_account.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <system_error>
+
+#include <td/telegram/Client.h>
+
+#include "engine/backend/sender_names.hpp"
+#include "engine/config/config.hpp"
+
+namespace engine::backend::telegram {
+
+namespace {
+
+// getChatHistory returns at most 100 messages per call
+constexpr std::int32_t kHistoryPageSize = 100;
+constexpr std::int32_t kMaxHistoryDepth = 10000;
+constexpr std::size_t kMaxHistorySegments = 4;
+
+constexpr std::chrono::seconds kRequestTimeout{10};
+// deep history pages can take a while on slow links before they count as lost
+constexpr std::chrono::seconds kHistoryRequestTimeout{15};
+// a timed-out query is resent this many times before it is given up on
+constexpr std::uint32_t kMaxRequestRetries = 1;
+
+struct RequestPolicy {
+    std::string_view function{};
+    std::optional<std::chrono::steady_clock::duration> timeout{};
+};
+
+// authorization and close wait on the user or on TDLib shutting down, so they get no deadline
+auto request_policy(const td::td_api::Function& function) -> RequestPolicy {
+    switch (function.get_id()) {
+        case td::td_api::getChats::ID:
+            return {"getChats", kRequestTimeout};
+        case td::td_api::getChat::ID:
+            return {"getChat", kRequestTimeout};
+        case td::td_api::getChatHistory::ID:
+            return {"getChatHistory", kHistoryRequestTimeout};
+        case td::td_api::getChatMessageByDate::ID:
+            return {"getChatMessageByDate", kHistoryRequestTimeout};
+        case td::td_api::sendMessage::ID:
+            return {"sendMessage", kRequestTimeout};
+        case td::td_api::getAuthorizationState::ID:
+            return {"getAuthorizationState", std::nullopt};
+        case td::td_api::setTdlibParameters::ID:
+            return {"setTdlibParameters", std::nullopt};
+        case td::td_api::setAuthenticationPhoneNumber::ID:
+            return {"setAuthenticationPhoneNumber", std::nullopt};
+        case td::td_api::checkAuthenticationCode::ID:
+            return {"checkAuthenticationCode", std::nullopt};
+        case td::td_api::checkAuthenticationPassword::ID:
+            return {"checkAuthenticationPassword", std::nullopt};
+        case td::td_api::close::ID:
+            return {"close", std::nullopt};
+        default:
+            return {"other", kRequestTimeout};
+    }
+}
+
+}  // namespace
+
+TelegramAccount::TelegramAccount(td::ClientManager& client_manager,
+                                 AccountId id,
+                                 engine::config::TelegramAccountSettings settings,
+                                 Emit emit)
+    : client_manager_{&client_manager},
+      id_{id},
+      settings_{std::move(settings)},
+      emit_{std::move(emit)},
+      tracker_{id} {}
+
+void TelegramAccount::open() {
+    emit(engine::events::EventId::BackendStatus,
+         BackendStatus{BackendStatusKind::Connecting, "Connecting to Telegram", id_});
+
+    client_id_ = client_manager_->create_client_id();
+    send_query(td::td_api::make_object<td::td_api::getAuthorizationState>());
+}
+
+void TelegramAccount::close() {
+    if (client_id_ == 0 || closed_ || closing_) {
+        return;
+    }
+
+    closing_ = true;
+    send_query(td::td_api::make_object<td::td_api::close>());
+}
+
+void TelegramAccount::request_chats(std::int32_t limit) {
+    if (!authorized_) {
+        return;
+    }
+
+    // answer from the update-fed cache right away; getChats still runs so the list order
+    // is confirmed and chats never announced through updates get fetched
+    auto cached = collect_cached_chats(static_cast<std::size_t>(std::max(limit, 0)));
+    if (!cached.empty()) {
+        emit(engine::events::EventId::BackendChatList, std::move(cached));
+    }
+
+    send_query(td::td_api::make_object<td::td_api::getChats>(nullptr, limit), 0, {.subject = limit});
+}
+
+void TelegramAccount::request_history(ChatId chat_id, std::int32_t limit, MessageId before) {
+    if (!authorized_) {
+        return;
+    }
+
+    const std::int32_t target = limit <= 0 ? 10 : std::min<std::int32_t>(limit, kMaxHistoryDepth);
+
+    // a new load supersedes any in-flight one from the same point; stale replies are
+    // dropped by generation
+    auto& load = history_loads_[HistoryLoadKey{chat_id, before}];
+    load = HistoryLoad{};
+    load.generation = next_history_generation_++;
+    load.before = before;
+    load.target = target;
+    load.segments.push_back(HistorySegment{
+        // the latest known message, or the oldest one the receiver still holds
+        .from_message_id = before != 0 ? before : std::numeric_limits<std::int64_t>::max()
+    });
+
+    send_history_page(chat_id, load, 0);
+}
+
+void TelegramAccount::send_message(ChatId chat_id, std::string_view text) {
+    if (!authorized_) {
+        return;
+    }
+
+    auto send_message = td::td_api::make_object<td::td_api::sendMessage>();
+    send_message->chat_id_ = chat_id;
+
+    auto content = td::td_api::make_object<td::td_api::inputMessageText>();
+    content->text_ = td::td_api::make_object<td::td_api::formattedText>();
+    content->text_->text_ = std::string{text};
+    send_message->input_message_content_ = std::move(content);
+
+    send_query(std::move(send_message));
+}
+
+void TelegramAccount::process_response(td::ClientManager::Response response) {
+    if (response.request_id == 0) {
+        handle_update(std::move(response.object));
+        return;
+    }
+
+    // a reply that arrives after its deadline was already retried or cleaned up
+    const auto request_id = static_cast<std::int64_t>(response.request_id);
+    if (!tracker_.complete(request_id)) {
+        return;
+    }
+
+    handle_response(request_id, std::move(response.object));
+}
+
+void TelegramAccount::expire_requests(RequestTracker::Clock::time_point now) {
+    for (const auto& expired : tracker_.take_expired(now)) {
+        handle_timeout(expired);
+    }
+}
+
+void TelegramAccount::handle_update(TdObject update) {
+    const auto id = update->get_id();
+
+    if (id == td::td_api::updateAuthorizationState::ID) {
+        auto state = td::td_api::move_object_as<td::td_api::updateAuthorizationState>(std::move(update));
+        handle_authorization_state(std::move(state->authorization_state_));
+        return;
+    }
+
+    if (id == td::td_api::updateNewMessage::ID) {
+        auto new_message = td::td_api::move_object_as<td::td_api::updateNewMessage>(std::move(update));
+        handle_new_message(std::move(new_message));
+        return;
+    }
+
+    if (id == td::td_api::updateNewChat::ID ||
+        id == td::td_api::updateChatTitle::ID ||
+        id == td::td_api::updateChatLastMessage::ID ||
+        id == td::td_api::updateChatPosition::ID ||
+        id == td::td_api::updateChatReadInbox::ID) {
+        handle_chat_update(std::move(update));
+        return;
+    }
+
+    if (id == td::td_api::updateUser::ID) {
+        auto user_update = td::td_api::move_object_as<td::td_api::updateUser>(std::move(update));
+        if (user_update->user_ != nullptr) {
+            const auto& user = *user_update->user_;
+            auto name = user.first_name_;
+            if (!user.last_name_.empty()) {
+                name += ' ';
+                name += user.last_name_;
+            }
+            SenderNames::assign(SenderId{SenderKind::User, user.id_}, name);
+        }
+    }
+}
+
+void TelegramAccount::handle_chat_update(TdObject update) {
+    const auto id = update->get_id();
+
+    if (id == td::td_api::updateNewChat::ID) {
+        auto new_chat = td::td_api::move_object_as<td::td_api::updateNewChat>(std::move(update));
+        if (new_chat->chat_ != nullptr) {
+            cache_chat(*new_chat->chat_);
+        }
+        return;
+    }
+
+    // the rest only amend chats already cached from a full chat object; a partial entry
+    // would make handle_chats skip the getChat that fills in the rest
+    if (id == td::td_api::updateChatTitle::ID) {
+        auto chat_title = td::td_api::move_object_as<td::td_api::updateChatTitle>(std::move(update));
+        const auto it = chat_cache_.find(chat_title->chat_id_);
+        if (it == chat_cache_.end()) {
+            return;
+        }
+        auto& summary = it->second;
+        summary.title = std::move(chat_title->title_);
+        SenderNames::assign(SenderId{SenderKind::Chat, summary.id}, summary.title);
+        return;
+    }
+
+    if (id == td::td_api::updateChatLastMessage::ID) {
+        auto last_message = td::td_api::move_object_as<td::td_api::updateChatLastMessage>(std::move(update));
+        const auto it = chat_cache_.find(last_message->chat_id_);
+        if (it == chat_cache_.end()) {
+            return;
+        }
+        auto& summary = it->second;
+        summary.last_message = last_message->last_message_ != nullptr
+            ? to_backend_message(*last_message->last_message_, live_text_)
+            : std::nullopt;
+        for (const auto& position : last_message->positions_) {
+            if (position != nullptr) {
+                apply_chat_position(summary, *position);
+            }
+        }
+        return;
+    }
+
+    if (id == td::td_api::updateChatPosition::ID) {
+        auto chat_position = td::td_api::move_object_as<td::td_api::updateChatPosition>(std::move(update));
+        const auto it = chat_cache_.find(chat_position->chat_id_);
+        if (chat_position->position_ != nullptr && it != chat_cache_.end()) {
+            apply_chat_position(it->second, *chat_position->position_);
+        }
+        return;
+    }
+
+    if (id == td::td_api::updateChatReadInbox::ID) {
+        auto read_inbox = td::td_api::move_object_as<td::td_api::updateChatReadInbox>(std::move(update));
+        if (const auto it = chat_cache_.find(read_inbox->chat_id_); it != chat_cache_.end()) {
+            it->second.unread_count = read_inbox->unread_count_;
+        }
+    }
+}
+
+void TelegramAccount::handle_response(std::int64_t request_id, TdObject object) {
+    if (history_requests_.contains(request_id)) {
+        handle_history_response(request_id, std::move(object));
+        return;
+    }
+
+    if (object->get_id() == td::td_api::error::ID) {
+        auto error = td::td_api::move_object_as<td::td_api::error>(object);
+        if (!auth_ready_) {
+            auth_failed_ = true;
+            auth_error_ = "TDLib error: " + error->message_;
+        }
+        emit(engine::events::EventId::BackendStatus,
+             BackendStatus{BackendStatusKind::Error, error->message_, id_});
+        return;
+    }
+
+    const auto object_id = object->get_id();
+
+    if (object_id == td::td_api::chats::ID) {
+        handle_chats(td::td_api::move_object_as<td::td_api::chats>(object));
+        return;
+    }
+
+    if (object_id == td::td_api::chat::ID) {
+        handle_chat(td::td_api::move_object_as<td::td_api::chat>(object));
+        return;
+    }
+}
+
+void TelegramAccount::handle_authorization_state(td::td_api::object_ptr<td::td_api::AuthorizationState> state) {
+    if (state == nullptr) {
+        return;
+    }
+
+    const auto id = state->get_id();
+
+    if (id == td::td_api::authorizationStateReady::ID) {
+        authorized_ = true;
+        auth_ready_ = true;
+
+        emit(engine::events::EventId::BackendStatus,
+             BackendStatus{BackendStatusKind::Ready, "Authorized", id_});
+        
+        return;
+    }
+
+    if (id == td::td_api::authorizationStateWaitTdlibParameters::ID) {
+        send_tdlib_parameters();
+        return;
+    }
+
+    if (id == td::td_api::authorizationStateWaitPhoneNumber::ID) {
+        prompt_phone_number();
+        return;
+    }
+
+    if (id == td::td_api::authorizationStateWaitCode::ID) {
+        prompt_auth_code();
+        return;
+    }
+
+    if (id == td::td_api::authorizationStateWaitPassword::ID) {
+        prompt_password();
+        return;
+    }
+
+    if (id == td::td_api::authorizationStateLoggingOut::ID) {
+        authorized_ = false;
+        return;
+    }
+
+    if (id == td::td_api::authorizationStateClosing::ID) {
+        authorized_ = false;
+        return;
+    }
+
+    if (id == td::td_api::authorizationStateClosed::ID) {
+        authorized_ = false;
+        closed_ = true;
+        if (!auth_ready_) {
+            auth_failed_ = true;
+            auth_error_ = "Authorization closed";
+        }
+    }
+}
+
+void TelegramAccount::handle_chats(td::td_api::object_ptr<td::td_api::chats> chats) {
+    if (chats == nullptr) {
+        return;
+    }
+
+    requested_chat_ids_ = chats->chat_ids_;
+    pending_chat_ids_.clear();
+    chat_list_dirty_ = false;
+
+    // only ids that never showed up in an update need a getChat round-trip
+    for (const auto chat_id : requested_chat_ids_) {
+        if (chat_cache_.contains(chat_id)) {
+            continue;
+        }
+        pending_chat_ids_.insert(chat_id);
+        send_query(td::td_api::make_object<td::td_api::getChat>(chat_id), 0, {.subject = chat_id});
+    }
+
+    // emit what is known now; getChat replies re-emit the list as they arrive, once per
+    // poll (see flush_chat_list), instead of stalling it
+    auto known = collect_requested_chats();
+    if (!known.empty() || requested_chat_ids_.empty()) {
+        emit(engine::events::EventId::BackendChatList, std::move(known));
+    }
+}
+
+void TelegramAccount::handle_chat(td::td_api::object_ptr<td::td_api::chat> chat) {
+    if (chat == nullptr) {
+        return;
+    }
+
+    cache_chat(*chat);
+    if (pending_chat_ids_.erase(chat->id_) != 0) {
+        chat_list_dirty_ = true;
+    }
+}
+
+void TelegramAccount::flush_chat_list() {
+    if (!chat_list_dirty_) {
+        return;
+    }
+    chat_list_dirty_ = false;
+    emit(engine::events::EventId::BackendChatList, collect_requested_chats());
+}
+
+auto TelegramAccount::collect_cached_chats(std::size_t limit) const -> std::vector<ChatSummary> {
+
+    std::vector<ChatSummary> chats{};
+    for (const auto& [chat_id, summary] : chat_cache_) {
+        if (summary.order != 0) {
+            chats.push_back(summary);
+        }
+    }
+
+    const auto count = std::min(limit, chats.size());
+    std::partial_sort(
+        chats.begin(),
+        chats.begin() + static_cast<std::ptrdiff_t>(count),
+        chats.end(),
+        [](const ChatSummary& lhs, const ChatSummary& rhs) { return lhs.order > rhs.order; }
+    );
+    chats.resize(count);
+    return chats;
+}
+
+auto TelegramAccount::collect_requested_chats() const -> std::vector<ChatSummary> {
+    std::vector<ChatSummary> chats{};
+    chats.reserve(requested_chat_ids_.size());
+    for (const auto chat_id : requested_chat_ids_) {
+        if (const auto it = chat_cache_.find(chat_id); it != chat_cache_.end()) {
+            chats.push_back(it->second);
+        }
+    }
+    return chats;
+}
+
+void TelegramAccount::cache_chat(const td::td_api::chat& chat) {
+    auto& summary = chat_cache_[chat.id_];
+    summary.id = chat.id_;
+    summary.account = id_;
+    summary.title = chat.title_;
+    // channels post as the chat itself, so its title doubles as a sender name
+    SenderNames::assign(SenderId{SenderKind::Chat, chat.id_}, chat.title_);
+    summary.unread_count = chat.unread_count_;
+    summary.last_message = chat.last_message_ != nullptr
+        ? to_backend_message(*chat.last_message_, live_text_)
+        : std::nullopt;
+    for (const auto& position : chat.positions_) {
+        if (position != nullptr) {
+            apply_chat_position(summary, *position);
+        }
+    }
+}
+
+void TelegramAccount::apply_chat_position(ChatSummary& summary, const td::td_api::chatPosition& position) {
+    // only the main list drives ordering; archive and folder positions are ignored
+    if (position.list_ == nullptr || position.list_->get_id() != td::td_api::chatListMain::ID) {
+        return;
+    }
+    summary.order = position.order_;
+}
+
+void TelegramAccount::handle_history_response(std::int64_t request_id, TdObject object) {
+    const auto object_id = object->get_id();
+
+    if (object_id == td::td_api::messages::ID) {
+        handle_history_page(request_id, td::td_api::move_object_as<td::td_api::messages>(object));
+        return;
+    }
+
+    if (object_id == td::td_api::message::ID) {
+        handle_history_anchor(request_id, td::td_api::move_object_as<td::td_api::message>(object));
+        return;
+    }
+
+    // an error ends the segment it belongs to instead of failing the whole backend
+    const auto it = history_requests_.find(request_id);
+    const bool is_anchor = it != history_requests_.end() && it->second.kind == HistoryRequestKind::Anchor;
+
+    if (is_anchor) {
+        handle_history_anchor(request_id, nullptr);
+    } else {
+        handle_history_page(request_id, nullptr);
+    }
+}
+
+void TelegramAccount::handle_history_page(std::int64_t request_id,
+                                          td::td_api::object_ptr<td::td_api::messages> messages) {
+    const auto request_it = history_requests_.find(request_id);
+    if (request_it == history_requests_.end()) {
+        return;
+    }
+    const auto request = request_it->second;
+    history_requests_.erase(request_it);
+
+    const auto load_it = history_loads_.find(HistoryLoadKey{request.chat_id, request.before});
+    if (load_it == history_loads_.end() || load_it->second.generation != request.generation) {
+        return;
+    }
+    auto& load = load_it->second;
+    auto& segment = load.segments[request.segment];
+    segment.in_flight = false;
+
+    ChatHistory chunk{};
+    chunk.chat_id = request.chat_id;
+    chunk.account = id_;
+    chunk.before = request.before;
+
+    if (messages == nullptr || messages->messages_.empty()) {
+        segment.done = true;
+    } else {
+        const auto previous_from = segment.from_message_id;
+        std::int64_t newest_date = 0;
+        std::int64_t oldest_date = 0;
+        std::size_t page_count = 0;
+
+        for (auto& msg_ptr : messages->messages_) {
+            if (msg_ptr == nullptr) {
+                continue;
+            }
+
+            if (segment.stop_at_id != 0 && msg_ptr->id_ <= segment.stop_at_id) {
+                segment.done = true;
+                break;
+            }
+
+            if (page_count == 0) {
+                newest_date = msg_ptr->date_;
+            }
+            oldest_date = msg_ptr->date_;
+            ++page_count;
+            // anchor on the raw id so non-text messages still advance the cursor
+            segment.from_message_id = msg_ptr->id_;
+
+            if (!load.seen.insert(msg_ptr->id_).second) {
+                continue;
+            }
+
+            auto backend_msg = to_backend_message(*msg_ptr, load.arena);
+            if (!backend_msg.has_value()) {
+                continue;
+            }
+
+            chunk.messages.push_back(std::move(*backend_msg));
+            ++load.received;
+        }
+
+        // a page that does not move the cursor means the start of the chat was reached
+        if (segment.from_message_id == previous_from) {
+            segment.done = true;
+        }
+
+        if (request.segment == 0 && !load.planned) {
+            load.planned = true;
+            plan_history_segments(request.chat_id, load, newest_date, oldest_date, page_count);
+        }
+    }
+
+    pump_history(request.chat_id, load);
+
+    const bool finished = is_history_finished(load);
+
+    if (!chunk.messages.empty() || finished) {
+        chunk.append = load.emitted_first;
+        chunk.complete = finished;
+        load.emitted_first = true;
+        emit(engine::events::EventId::BackendChatHistory, std::make_shared<const ChatHistory>(std::move(chunk)));
+    }
+
+    if (finished) {
+        history_loads_.erase(load_it);
+    }
+}
+
+void TelegramAccount::handle_history_anchor(std::int64_t request_id,
+                                            td::td_api::object_ptr<td::td_api::message> message) {
+    const auto request_it = history_requests_.find(request_id);
+    if (request_it == history_requests_.end()) {
+        return;
+    }
+    const auto request = request_it->second;
+    history_requests_.erase(request_it);
+
+    const auto load_it = history_loads_.find(HistoryLoadKey{request.chat_id, request.before});
+    if (load_it == history_loads_.end() || load_it->second.generation != request.generation) {
+        return;
+    }
+    auto& load = load_it->second;
+    auto& segment = load.segments[request.segment];
+    segment.awaiting_anchor = false;
+
+    // the anchor has to be strictly older than the newer segment's cursor, otherwise the
+    // date estimate was off and the newer segment covers this range on its own
+    const auto newer_index = newer_live_segment(load, request.segment);
+    auto& newer = load.segments[newer_index];
+    const bool newer_has_cursor = !newer.awaiting_anchor;
+    if (message == nullptr || (newer.done && newer_has_cursor) ||
+        (newer_has_cursor && message->id_ >= newer.from_message_id)) {
+        segment.done = true;
+        segment.skipped = true;
+        // whatever bounded this segment now bounds the newer one
+        newer.stop_at_id = std::max(newer.stop_at_id, segment.stop_at_id);
+    } else {
+        segment.from_message_id = message->id_;
+        newer.stop_at_id = message->id_;
+    }
+
+    pump_history(request.chat_id, load);
+
+    if (is_history_finished(load)) {
+        ChatHistory chunk{};
+        chunk.chat_id = request.chat_id;
+        chunk.account = id_;
+        chunk.before = request.before;
+        chunk.append = load.emitted_first;
+        chunk.complete = true;
+        emit(engine::events::EventId::BackendChatHistory, std::make_shared<const ChatHistory>(std::move(chunk)));
+        history_loads_.erase(load_it);
+    }
+}
+
+auto TelegramAccount::is_history_finished(const HistoryLoad& load) -> bool {
+    return std::all_of(load.segments.begin(), load.segments.end(), [](const HistorySegment& segment) {
+        return segment.done && !segment.in_flight && !segment.awaiting_anchor;
+    });
+}
+
+auto TelegramAccount::newer_live_segment(const HistoryLoad& load, std::size_t index) -> std::size_t {
+    while (index > 0) {
+        --index;
+        if (!load.segments[index].skipped) {
+            return index;
+        }
+    }
+    return 0;
+}
+
+void TelegramAccount::plan_history_segments(ChatId chat_id,
+                                            HistoryLoad& load,
+                                            std::int64_t newest_date,
+                                            std::int64_t oldest_date,
+                                            std::size_t count) {
+    const auto remaining = load.target - load.received;
+    if (count < 2 || remaining <= kHistoryPageSize * 2 || newest_date <= oldest_date) {
+        return;
+    }
+
+    // estimate message density from the first page and place the extra segments at the
+    // dates where their share of the remaining messages should start
+    const auto extra = std::min<std::size_t>(
+        kMaxHistorySegments - 1,
+        static_cast<std::size_t>(remaining / kHistoryPageSize) - 1
+    );
+    const auto share = remaining / static_cast<std::int32_t>(extra + 1);
+    const double seconds_per_message =
+        static_cast<double>(newest_date - oldest_date) / static_cast<double>(count - 1);
+
+    for (std::size_t i = 1; i <= extra; ++i) {
+        const auto offset = static_cast<std::int64_t>(seconds_per_message * share * static_cast<double>(i));
+        const auto date = oldest_date - offset;
+        if (date <= 0) {
+            break;
+        }
+
+        load.segments.push_back(HistorySegment{.awaiting_anchor = true});
+        const auto request_id = next_request_id();
+        history_requests_[request_id] = HistoryRequest{
+            .chat_id = chat_id,
+            .before = load.before,
+            .generation = load.generation,
+            .segment = load.segments.size() - 1,
+            .kind = HistoryRequestKind::Anchor
+        };
+        send_query(td::td_api::make_object<td::td_api::getChatMessageByDate>(
+            chat_id,
+            static_cast<std::int32_t>(date)
+        ), request_id, {.subject = chat_id});
+    }
+}
+
+void TelegramAccount::pump_history(ChatId chat_id, HistoryLoad& load) {
+    const auto oldest = oldest_live_segment(load);
+
+    for (std::size_t i = 0; i < load.segments.size(); ++i) {
+        auto& segment = load.segments[i];
+        if (segment.done || segment.in_flight || segment.awaiting_anchor) {
+            continue;
+        }
+
+        // only the oldest segment is bounded by the target; the newer ones run until they
+        // reach the next segment's anchor so the merged history has no gaps
+        if (i == oldest && load.received >= load.target) {
+            segment.done = true;
+            continue;
+        }
+
+        send_history_page(chat_id, load, i);
+    }
+}
+
+auto TelegramAccount::oldest_live_segment(const HistoryLoad& load) -> std::size_t {
+    for (std::size_t i = load.segments.size(); i-- > 0;) {
+        if (!load.segments[i].skipped) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+void TelegramAccount::send_history_page(ChatId chat_id,
+                                        HistoryLoad& load,
+                                        std::size_t segment_index,
+                                        std::uint32_t attempt) {
+    auto& segment = load.segments[segment_index];
+    const bool is_last = segment_index == oldest_live_segment(load);
+    // the first page of an anchored segment starts one message newer to include the anchor
+    const bool include_anchor = segment_index != 0 && !load.seen.contains(segment.from_message_id);
+    const auto limit = is_last
+        ? std::clamp<std::int32_t>(load.target - load.received, include_anchor ? 2 : 1, kHistoryPageSize)
+        : kHistoryPageSize;
+
+    const auto request_id = next_request_id();
+    history_requests_[request_id] = HistoryRequest{
+        .chat_id = chat_id,
+        .before = load.before,
+        .generation = load.generation,
+        .segment = segment_index,
+        .kind = HistoryRequestKind::Page
+    };
+    segment.in_flight = true;
+
+    send_query(td::td_api::make_object<td::td_api::getChatHistory>(
+        chat_id,
+        segment.from_message_id,
+        include_anchor ? -1 : 0,
+        limit,
+        false
+    ), request_id, {.subject = chat_id, .attempt = attempt});
+}
+
+void TelegramAccount::handle_new_message(td::td_api::object_ptr<td::td_api::updateNewMessage> update) {
+    if (update == nullptr || update->message_ == nullptr) {
+        return;
+    }
+
+    const auto backend_msg = to_backend_message(*update->message_, live_text_);
+    if (!backend_msg.has_value()) {
+        return;
+    }
+
+    emit(engine::events::EventId::BackendNewMessage, *backend_msg);
+}
+
+void TelegramAccount::handle_timeout(const RequestTracker::Expired& expired) {
+    const bool can_retry = expired.context.attempt < kMaxRequestRetries && !closing_;
+    const RequestContext retry{.subject = expired.context.subject, .attempt = expired.context.attempt + 1};
+
+    if (const auto it = history_requests_.find(expired.request_id); it != history_requests_.end()) {
+        const auto request = it->second;
+        const auto load_it = history_loads_.find(HistoryLoadKey{request.chat_id, request.before});
+        const bool current = load_it != history_loads_.end() && load_it->second.generation == request.generation;
+
+        // a page is resent from the same cursor; anything else ends like a failed reply, so
+        // an anchor falls back to the newer segment and a page finishes its segment
+        if (current && can_retry && request.kind == HistoryRequestKind::Page) {
+            history_requests_.erase(it);
+            load_it->second.segments[request.segment].in_flight = false;
+            send_history_page(request.chat_id, load_it->second, request.segment, retry.attempt);
+            return;
+        }
+
+        handle_history_response(expired.request_id, td::td_api::make_object<td::td_api::error>(408, "timeout"));
+        return;
+    }
+
+    if (expired.function == "getChats" && can_retry) {
+        send_query(td::td_api::make_object<td::td_api::getChats>(
+            nullptr,
+            static_cast<std::int32_t>(expired.context.subject)
+        ), 0, retry);
+        return;
+    }
+
+    if (expired.function == "getChat") {
+        const auto chat_id = expired.context.subject;
+        if (!pending_chat_ids_.contains(chat_id)) {
+            return;
+        }
+        if (can_retry) {
+            send_query(td::td_api::make_object<td::td_api::getChat>(chat_id), 0, retry);
+            return;
+        }
+
+        // give up on this chat rather than holding back the rest of the list
+        pending_chat_ids_.erase(chat_id);
+        chat_list_dirty_ = true;
+    }
+
+    // sends are not retried so a slow reply can never post the same message twice
+}
+
+auto TelegramAccount::next_request_id() -> std::int64_t {
+    return next_query_id_++;
+}
+
+void TelegramAccount::emit(engine::events::EventId id, engine::events::EventPayload payload) {
+    if (emit_) {
+        emit_(id, std::move(payload));
+    }
+}
+
+void TelegramAccount::send_query(td::td_api::object_ptr<td::td_api::Function> function,
+                                 std::int64_t request_id,
+                                 RequestContext context) {
+    const auto query_id = request_id != 0 ? request_id : next_request_id();
+    const auto policy = request_policy(*function);
+    tracker_.begin(query_id, policy.function, policy.timeout, context);
+    client_manager_->send(
+        client_id_,
+        static_cast<td::ClientManager::RequestId>(query_id),
+        std::move(function)
+    );
+}
+
+void TelegramAccount::send_tdlib_parameters() {
+    auto request = td::td_api::make_object<td::td_api::setTdlibParameters>();
+    request->use_test_dc_ = false;
+    request->database_directory_ = settings_.database_directory;
+    request->use_message_database_ = true;
+    request->use_secret_chats_ = true;
+    const auto& cfg = engine::config::ConfigService::ref();
+    request->api_id_ = cfg.telegram.api_id;
+    request->api_hash_ = cfg.telegram.api_hash;
+    request->system_language_code_ = "en";
+    request->device_model_ = "lounge";
+    request->application_version_ = "0.1";
+
+    if (request->api_id_ == 0 || request->api_hash_.empty()) {
+        std::string api_id_input = prompt_line("Enter Telegram api_id: ");
+        std::string api_hash_input = prompt_line("Enter Telegram api_hash: ");
+
+        int api_id_value = 0;
+        const auto* begin = api_id_input.data();
+        const auto* end = api_id_input.data() + api_id_input.size();
+        const auto parse_result = std::from_chars(begin, end, api_id_value);
+        if (parse_result.ec == std::errc{}) {
+            request->api_id_ = api_id_value;
+        } else {
+            request->api_id_ = 0;
+        }
+        request->api_hash_ = std::move(api_hash_input);
+    }
+
+    if (request->api_id_ != 0 && !request->api_hash_.empty()) {
+        [[maybe_unused]] const auto _ = engine::config::ConfigService::set_telegram_credentials(
+            request->api_id_,
+            request->api_hash_
+        );
+    }
+
+    send_query(std::move(request));
+}
+
+void TelegramAccount::prompt_phone_number() {
+    std::string phone;
+    while (phone.empty()) {
+        phone = prompt_line("Enter phone number (e.g., +15551234567): ");
+    }
+    send_query(td::td_api::make_object<td::td_api::setAuthenticationPhoneNumber>(phone, nullptr));
+}
+
+void TelegramAccount::prompt_auth_code() {
+    std::string code;
+    while (code.empty()) {
+        code = prompt_line("Enter authentication code: ");
+    }
+    send_query(td::td_api::make_object<td::td_api::checkAuthenticationCode>(code));
+}
+
+void TelegramAccount::prompt_password() {
+    std::string password;
+    while (password.empty()) {
+        password = prompt_line("Enter password: ");
+    }
+    send_query(td::td_api::make_object<td::td_api::checkAuthenticationPassword>(password));
+}
+
+auto TelegramAccount::prompt_line(std::string_view label) -> std::string {
+    // several accounts may be authorizing at once, so say which one is asking
+    std::cerr << "[" << settings_.name << "] " << label;
+    std::cerr.flush();
+    std::string line;
+    if (!std::getline(std::cin, line)) {
+        std::cin.clear();
+    }
+    return line;
+}
+
+auto TelegramAccount::to_backend_message(const td::td_api::message& message, engine::backend::TextArena& arena)
+    -> std::optional<engine::backend::Message> {
+    if (message.content_ == nullptr) {
+        return std::nullopt;
+    }
+
+    const auto text = extract_text(*message.content_);
+    if (!text.has_value()) {
+        return std::nullopt;
+    }
+
+    engine::backend::Message backend_msg{};
+    backend_msg.id = message.id_;
+    backend_msg.chat_id = message.chat_id_;
+    backend_msg.account = id_;
+    backend_msg.text = arena.append(*text);
+    backend_msg.timestamp = message.date_;
+
+    if (message.sender_id_ != nullptr) {
+        const auto sender_id = message.sender_id_->get_id();
+        if (sender_id == td::td_api::messageSenderUser::ID) {
+            const auto& sender = static_cast<const td::td_api::messageSenderUser&>(*message.sender_id_);
+            backend_msg.sender = SenderId{SenderKind::User, sender.user_id_};
+        } else if (sender_id == td::td_api::messageSenderChat::ID) {
+            const auto& sender = static_cast<const td::td_api::messageSenderChat&>(*message.sender_id_);
+            backend_msg.sender = SenderId{SenderKind::Chat, sender.chat_id_};
+        }
+    }
+
+    return backend_msg;
+}
+
+auto TelegramAccount::extract_text(const td::td_api::MessageContent& content)
+    -> std::optional<std::string_view> {
+    if (content.get_id() != td::td_api::messageText::ID) {
+        return std::nullopt;
+    }
+
+    const auto& message_text = static_cast<const td::td_api::messageText&>(content);
+    if (message_text.text_ == nullptr) {
+        return std::nullopt;
+    }
+
+    return message_text.text_->text_;
+}
+
+}  // namespace engine::backend::telegram
+
+
+
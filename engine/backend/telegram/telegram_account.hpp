@@ -0,0 +1,190 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <td/telegram/Client.h>
+#include <td/telegram/td_api.h>
+#include <td/telegram/td_api.hpp>
+
+#include "engine/backend/backend_types.hpp"
+#include "engine/backend/request_tracker.hpp"
+#include "engine/config/config.hpp"
+#include "engine/events/event.hpp"
+
+namespace engine::backend::telegram {
+
+// One TDLib client and everything known about its account. Accounts share the
+// TelegramBackend's ClientManager and reactor thread; the backend routes each response
+// here by client id, and every event emitted is tagged with the account id.
+class TelegramAccount {
+public:
+    using Emit = std::function<void(engine::events::EventId, engine::events::EventPayload)>;
+
+    TelegramAccount(td::ClientManager& client_manager,
+                    AccountId id,
+                    engine::config::TelegramAccountSettings settings,
+                    Emit emit);
+    TelegramAccount(const TelegramAccount&) = delete;
+    auto operator=(const TelegramAccount&) -> TelegramAccount& = delete;
+    TelegramAccount(TelegramAccount&&) = delete;
+    auto operator=(TelegramAccount&&) -> TelegramAccount& = delete;
+    ~TelegramAccount() = default;
+
+    // creates the client and starts authorization; progress arrives through process_response
+    void open();
+    void close();
+    void process_response(td::ClientManager::Response response);
+    // retries or abandons every query whose deadline passed before `now`
+    void expire_requests(RequestTracker::Clock::time_point now);
+    // re-emits the requested chat list if getChat replies or timeouts changed it; called
+    // once per poll so a burst of replies produces one list
+    void flush_chat_list();
+
+    [[nodiscard]] auto id() const noexcept -> AccountId { return id_; }
+    [[nodiscard]] auto name() const noexcept -> const std::string& { return settings_.name; }
+    [[nodiscard]] auto client_id() const noexcept -> td::ClientManager::ClientId { return client_id_; }
+    [[nodiscard]] auto auth_settled() const noexcept -> bool { return auth_ready_ || auth_failed_; }
+    [[nodiscard]] auto authorized() const noexcept -> bool { return authorized_; }
+    [[nodiscard]] auto closed() const noexcept -> bool { return closed_; }
+    [[nodiscard]] auto auth_error() const noexcept -> const std::string& { return auth_error_; }
+    [[nodiscard]] auto requests() const noexcept -> const RequestTracker& { return tracker_; }
+
+    void request_chats(std::int32_t limit);
+    void request_history(ChatId chat_id, std::int32_t limit, MessageId before);
+    void send_message(ChatId chat_id, std::string_view text);
+
+private:
+    using TdObject = td::td_api::object_ptr<td::td_api::Object>;
+
+    void handle_update(TdObject update);
+    void handle_response(std::int64_t request_id, TdObject object);
+
+    void handle_authorization_state(td::td_api::object_ptr<td::td_api::AuthorizationState> state);
+    void handle_chats(td::td_api::object_ptr<td::td_api::chats> chats);
+    void handle_chat(td::td_api::object_ptr<td::td_api::chat> chat);
+    void handle_chat_update(TdObject update);
+    [[nodiscard]] auto collect_cached_chats(std::size_t limit) const -> std::vector<ChatSummary>;
+    [[nodiscard]] auto collect_requested_chats() const -> std::vector<ChatSummary>;
+    void cache_chat(const td::td_api::chat& chat);
+    static void apply_chat_position(ChatSummary& summary, const td::td_api::chatPosition& position);
+    void handle_history_response(std::int64_t request_id, TdObject object);
+    void handle_history_page(std::int64_t request_id, td::td_api::object_ptr<td::td_api::messages> messages);
+    void handle_history_anchor(std::int64_t request_id, td::td_api::object_ptr<td::td_api::message> message);
+    void handle_new_message(td::td_api::object_ptr<td::td_api::updateNewMessage> update);
+    void handle_timeout(const RequestTracker::Expired& expired);
+
+    void emit(engine::events::EventId id, engine::events::EventPayload payload);
+    [[nodiscard]] auto next_request_id() -> std::int64_t;
+    void send_query(td::td_api::object_ptr<td::td_api::Function> function,
+                    std::int64_t request_id = 0,
+                    RequestContext context = {});
+
+    void send_tdlib_parameters();
+
+    // TODO: these are for debugging purposes only, remove later
+    void prompt_phone_number();
+    void prompt_auth_code();
+    void prompt_password();
+
+    [[nodiscard]] auto prompt_line(std::string_view label) -> std::string;
+
+    struct HistoryLoad;
+    void plan_history_segments(ChatId chat_id,
+                               HistoryLoad& load,
+                               std::int64_t newest_date,
+                               std::int64_t oldest_date,
+                               std::size_t count);
+    void pump_history(ChatId chat_id, HistoryLoad& load);
+    [[nodiscard]] static auto newer_live_segment(const HistoryLoad& load, std::size_t index) -> std::size_t;
+    [[nodiscard]] static auto oldest_live_segment(const HistoryLoad& load) -> std::size_t;
+    [[nodiscard]] static auto is_history_finished(const HistoryLoad& load) -> bool;
+    void send_history_page(ChatId chat_id, HistoryLoad& load, std::size_t segment_index, std::uint32_t attempt = 0);
+
+    [[nodiscard]] auto to_backend_message(const td::td_api::message& message, engine::backend::TextArena& arena)
+        -> std::optional<engine::backend::Message>;
+    [[nodiscard]] static auto extract_text(const td::td_api::MessageContent& content)
+        -> std::optional<std::string_view>;
+
+    // only ever touched from the reactor thread
+    td::ClientManager* client_manager_{nullptr};
+    AccountId id_{0};
+    engine::config::TelegramAccountSettings settings_{};
+    Emit emit_{};
+    td::ClientManager::ClientId client_id_{0};
+    std::int64_t next_query_id_{1};
+    RequestTracker tracker_;
+
+    bool authorized_{false};
+    bool auth_ready_{false};
+    bool auth_failed_{false};
+    bool closing_{false};
+    bool closed_{false};
+    std::string auth_error_{};
+
+    // chat metadata kept current by TDLib updates so chat lists can be served without a
+    // getChat round-trip per entry
+    std::unordered_map<ChatId, engine::backend::ChatSummary> chat_cache_{};
+    // text of live messages and chat previews; history pages use their load's arena, so
+    // at most one partly filled chunk is held here however many chats are seen
+    engine::backend::TextArena live_text_{};
+    std::vector<ChatId> requested_chat_ids_{};
+    std::unordered_set<ChatId> pending_chat_ids_{};
+    bool chat_list_dirty_{false};
+
+    // a deep load is split into segments ordered newest to oldest; every segment pages
+    // independently so several getChatHistory requests can be in flight for one chat
+    struct HistorySegment {
+        MessageId from_message_id{0};
+        MessageId stop_at_id{0};  // the next older segment starts here; 0 while unknown
+        bool awaiting_anchor{false};
+        bool in_flight{false};
+        bool done{false};
+        bool skipped{false};  // anchor was missing or overlapped a newer segment
+    };
+
+    struct HistoryLoad {
+        std::uint64_t generation{0};
+        MessageId before{0};  // 0 when paging down from the newest message
+        std::int32_t target{0};
+        std::int32_t received{0};
+        bool planned{false};
+        bool emitted_first{false};
+        // the load's message text; its chunks go once the load and its messages are gone
+        engine::backend::TextArena arena{};
+        std::unordered_set<MessageId> seen{};
+        std::vector<HistorySegment> segments{};
+    };
+
+    enum class HistoryRequestKind { Page, Anchor };
+
+    struct HistoryRequest {
+        ChatId chat_id{0};
+        MessageId before{0};
+        std::uint64_t generation{0};
+        std::size_t segment{0};
+        HistoryRequestKind kind{HistoryRequestKind::Page};
+    };
+
+    // one load per chat and starting point, so an older range fills in while the newest
+    // page loads
+    struct HistoryLoadKey {
+        ChatId chat_id{0};
+        MessageId before{0};
+        auto operator<=>(const HistoryLoadKey&) const = default;
+    };
+
+    std::map<HistoryLoadKey, HistoryLoad> history_loads_{};
+    std::unordered_map<std::int64_t, HistoryRequest> history_requests_{};
+    std::uint64_t next_history_generation_{1};
+};
+
+}  // namespace engine::backend::telegram
+
+
+
@@ -0,0 +1,589 @@
+#include "engine/cache/chat_cache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if defined(_WIN32)
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace engine::cache {
+
+namespace {
+
+using engine::backend::ChatKey;
+using engine::backend::ChatKeyHash;
+using engine::backend::ChatSummary;
+using engine::backend::Message;
+using engine::backend::MessageId;
+using engine::backend::SenderId;
+using engine::backend::TextArena;
+
+constexpr std::array<char, 4> kMagic{'L', 'N', 'G', 'C'};
+constexpr std::uint32_t kVersion = 3;
+constexpr std::size_t kRecordAlignment = 8;
+// below this size a file full of superseded records is not worth rewriting
+constexpr std::uintmax_t kCompactMinBytes = 1U << 20U;
+
+// on-disk layout; native endianness, the cache never leaves the machine that wrote it
+struct FileHeader {
+    std::array<char, 4> magic{};
+    std::uint32_t version{0};
+};
+
+enum class RecordKind : std::uint32_t { Chat = 1, Message = 2 };
+
+// `size` covers the record body including its trailing padding
+struct RecordHeader {
+    std::uint32_t size{0};
+    RecordKind kind{RecordKind::Chat};
+};
+
+// followed by `title_size` bytes of title
+struct ChatRecord {
+    std::int64_t id{0};
+    std::int64_t order{0};
+    std::int32_t unread_count{0};
+    std::uint32_t title_size{0};
+    std::uint32_t account{0};
+    std::uint32_t reserved{0};
+};
+
+// followed by `text_size` bytes of text
+struct MessageRecord {
+    std::int64_t id{0};
+    std::int64_t chat_id{0};
+    std::int64_t timestamp{0};
+    std::int64_t sender_id{0};
+    std::uint32_t sender_kind{0};
+    std::uint32_t text_size{0};
+    std::uint32_t account{0};
+    std::uint32_t reserved{0};
+};
+
+static_assert(std::is_trivially_copyable_v<FileHeader> && sizeof(FileHeader) == 8);
+static_assert(std::is_trivially_copyable_v<RecordHeader> && sizeof(RecordHeader) == 8);
+static_assert(std::is_trivially_copyable_v<ChatRecord> && sizeof(ChatRecord) == 32);
+static_assert(std::is_trivially_copyable_v<MessageRecord> && sizeof(MessageRecord) == 48);
+
+auto padded(std::size_t size) -> std::size_t {
+    return (size + kRecordAlignment - 1) & ~(kRecordAlignment - 1);
+}
+
+// read-only view of a whole file; falls back to reading into memory where mmap is missing
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path& path) {
+#if defined(_WIN32)
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            return;
+        }
+        buffer_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        bytes_ = std::as_bytes(std::span{buffer_});
+        valid_ = !file.bad();
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+
+        struct stat info {};
+        if (::fstat(fd, &info) == 0) {
+            const auto size = static_cast<std::size_t>(info.st_size);
+            if (size == 0) {
+                valid_ = true;
+            } else {
+                void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data != MAP_FAILED) {
+                    // records are replayed front to back exactly once
+                    ::madvise(data, size, MADV_SEQUENTIAL);
+                    bytes_ = std::span{static_cast<const std::byte*>(data), size};
+                    valid_ = true;
+                }
+            }
+        }
+        ::close(fd);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    auto operator=(const MappedFile&) -> MappedFile& = delete;
+    MappedFile(MappedFile&&) = delete;
+    auto operator=(MappedFile&&) -> MappedFile& = delete;
+
+    ~MappedFile() {
+#if !defined(_WIN32)
+        if (!bytes_.empty()) {
+            ::munmap(const_cast<std::byte*>(bytes_.data()), bytes_.size());
+        }
+#endif
+    }
+
+    [[nodiscard]] auto valid() const -> bool { return valid_; }
+    [[nodiscard]] auto bytes() const -> std::span<const std::byte> { return bytes_; }
+
+private:
+    std::span<const std::byte> bytes_{};
+    bool valid_{false};
+#if defined(_WIN32)
+    std::vector<char> buffer_{};
+#endif
+};
+
+template <typename T>
+auto read_at(std::span<const std::byte> bytes, std::size_t offset) -> T {
+    T value{};
+    std::memcpy(&value, bytes.data() + offset, sizeof(T));
+    return value;
+}
+
+auto text_at(std::span<const std::byte> bytes, std::size_t offset, std::size_t size) -> std::string_view {
+    return {reinterpret_cast<const char*>(bytes.data() + offset), size};
+}
+
+// newest first, so trimming to the cap drops from the back
+using MessageMap = std::map<MessageId, Message, std::greater<>>;
+
+struct ReplayResult {
+    std::unordered_map<ChatKey, ChatSummary, ChatKeyHash> chats{};
+    std::unordered_map<ChatKey, MessageMap, ChatKeyHash> messages{};
+    // replayed text is copied out of the mapping into one arena per chat
+    std::unordered_map<ChatKey, TextArena, ChatKeyHash> arenas{};
+    std::size_t valid_end{0};
+    bool header_ok{false};
+};
+
+auto replay(std::span<const std::byte> bytes, std::size_t max_messages_per_chat) -> ReplayResult {
+    ReplayResult result{};
+
+    if (bytes.size() < sizeof(FileHeader)) {
+        return result;
+    }
+    const auto header = read_at<FileHeader>(bytes, 0);
+    if (header.magic != kMagic || header.version != kVersion) {
+        return result;
+    }
+    result.header_ok = true;
+
+    std::size_t offset = sizeof(FileHeader);
+    while (bytes.size() - offset >= sizeof(RecordHeader)) {
+        const auto record = read_at<RecordHeader>(bytes, offset);
+        const auto body = offset + sizeof(RecordHeader);
+
+        // a torn tail from a crash mid-append ends the replay
+        if (record.size > bytes.size() - body) {
+            break;
+        }
+
+        if (record.kind == RecordKind::Chat && record.size >= sizeof(ChatRecord)) {
+            const auto chat = read_at<ChatRecord>(bytes, body);
+            if (sizeof(ChatRecord) + chat.title_size > record.size) {
+                break;
+            }
+
+            auto& summary = result.chats[ChatKey{chat.account, chat.id}];
+            summary.id = chat.id;
+            summary.account = chat.account;
+            summary.order = chat.order;
+            summary.unread_count = chat.unread_count;
+            summary.title = text_at(bytes, body + sizeof(ChatRecord), chat.title_size);
+        } else if (record.kind == RecordKind::Message && record.size >= sizeof(MessageRecord)) {
+            const auto stored = read_at<MessageRecord>(bytes, body);
+            if (sizeof(MessageRecord) + std::size_t{stored.text_size} > record.size) {
+                break;
+            }
+
+            // a kind no sender has is a bad record; skip it and let compaction drop it
+            const auto kind = engine::backend::sender_kind_from(stored.sender_kind);
+            if (!kind.has_value()) {
+                offset = body + record.size;
+                continue;
+            }
+
+            const ChatKey key{stored.account, stored.chat_id};
+            auto& chat_messages = result.messages[key];
+            auto& message = chat_messages[stored.id];
+            message.id = stored.id;
+            message.chat_id = stored.chat_id;
+            message.account = stored.account;
+            message.timestamp = stored.timestamp;
+            message.sender = SenderId{*kind, stored.sender_id};
+            message.text = result.arenas[key].append(
+                text_at(bytes, body + sizeof(MessageRecord), stored.text_size)
+            );
+
+            if (chat_messages.size() > max_messages_per_chat) {
+                chat_messages.erase(std::prev(chat_messages.end()));
+            }
+        } else {
+            break;
+        }
+
+        offset = body + record.size;
+    }
+
+    result.valid_end = offset;
+    return result;
+}
+
+auto record_bytes(const ChatSummary& chat) -> std::size_t {
+    return sizeof(RecordHeader) + padded(sizeof(ChatRecord) + chat.title.size());
+}
+
+auto record_bytes(const Message& message) -> std::size_t {
+    return sizeof(RecordHeader) + padded(sizeof(MessageRecord) + message.text.size());
+}
+
+template <typename T>
+void write_pod(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void write_padding(std::string& out, std::size_t written) {
+    out.append(padded(written) - written, '\0');
+}
+
+void write_header(std::string& out) {
+    write_pod(out, FileHeader{kMagic, kVersion});
+}
+
+void write_chat(std::string& out, const ChatSummary& chat) {
+    const auto body = sizeof(ChatRecord) + chat.title.size();
+    write_pod(out, RecordHeader{static_cast<std::uint32_t>(padded(body)), RecordKind::Chat});
+    write_pod(out, ChatRecord{
+        chat.id,
+        chat.order,
+        chat.unread_count,
+        static_cast<std::uint32_t>(chat.title.size()),
+        chat.account
+    });
+    out += chat.title;
+    write_padding(out, body);
+}
+
+void write_message(std::string& out, const Message& message) {
+    const auto body = sizeof(MessageRecord) + message.text.size();
+    write_pod(out, RecordHeader{static_cast<std::uint32_t>(padded(body)), RecordKind::Message});
+    write_pod(out, MessageRecord{
+        message.id,
+        message.chat_id,
+        message.timestamp,
+        message.sender.id,
+        static_cast<std::uint32_t>(message.sender.kind),
+        static_cast<std::uint32_t>(message.text.size()),
+        message.account
+    });
+    out += message.text.view();
+    write_padding(out, body);
+}
+
+// the file as the next load would see it
+struct FileContents {
+    ChatCacheSnapshot snapshot{};
+    std::size_t file_size{0};
+    // the bytes a rewrite would need
+    std::size_t live_bytes{sizeof(FileHeader)};
+    bool header_ok{false};
+    bool torn{false};
+};
+
+auto read_file(const std::filesystem::path& path, std::size_t max_messages_per_chat)
+    -> std::expected<FileContents, std::string> {
+    ReplayResult replayed{};
+    FileContents contents{};
+    {
+        const MappedFile file{path};
+        if (!file.valid()) {
+            return std::unexpected("Failed to map chat cache: " + path.string());
+        }
+        contents.file_size = file.bytes().size();
+        replayed = replay(file.bytes(), max_messages_per_chat);
+    }
+    contents.header_ok = replayed.header_ok;
+    contents.torn = replayed.valid_end != contents.file_size;
+
+    auto& snapshot = contents.snapshot;
+    snapshot.history.reserve(replayed.messages.size());
+    for (auto& [key, messages] : replayed.messages) {
+        auto& history = snapshot.history[key];
+        history.reserve(messages.size());
+        for (auto& [id, message] : messages) {
+            contents.live_bytes += record_bytes(message);
+            history.push_back(std::move(message));
+        }
+    }
+
+    snapshot.chats.reserve(replayed.chats.size());
+    for (auto& [key, chat] : replayed.chats) {
+        contents.live_bytes += record_bytes(chat);
+        if (const auto it = snapshot.history.find(key); it != snapshot.history.end() && !it->second.empty()) {
+            chat.last_message = it->second.front();
+        }
+        snapshot.chats.push_back(std::move(chat));
+    }
+    std::sort(snapshot.chats.begin(), snapshot.chats.end(), [](const auto& lhs, const auto& rhs) {
+        if (lhs.account != rhs.account) {
+            return lhs.account < rhs.account;
+        }
+        return lhs.order != rhs.order ? lhs.order > rhs.order : lhs.id > rhs.id;
+    });
+    return contents;
+}
+
+// the writer rewrites the file once it has doubled, and never below kCompactMinBytes
+auto next_compaction(std::uintmax_t file_size) -> std::uintmax_t {
+    return std::max<std::uintmax_t>(kCompactMinBytes, 2 * file_size);
+}
+
+}  // namespace
+
+ChatCache::ChatCache(std::filesystem::path path)
+    : path_{std::move(path)} {}
+
+ChatCache::~ChatCache() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    wake_cv_.notify_one();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+}
+
+auto ChatCache::load() -> std::expected<ChatCacheSnapshot, std::string> {
+    std::error_code err{};
+    if (!std::filesystem::exists(path_, err)) {
+        return ChatCacheSnapshot{};
+    }
+
+    auto contents = read_file(path_, kMaxMessagesPerChat);
+    if (!contents.has_value()) {
+        return std::unexpected(contents.error());
+    }
+
+    // rewrite when the file is unreadable, torn, or mostly superseded records
+    const bool bloated = contents->file_size > kCompactMinBytes && contents->file_size > 2 * contents->live_bytes;
+    if (!contents->header_ok || contents->torn || bloated) {
+        if (auto compacted = compact(contents->snapshot); !compacted) {
+            return std::unexpected(compacted.error());
+        }
+    }
+
+    remember(contents->snapshot);
+    return std::move(contents->snapshot);
+}
+
+void ChatCache::store_chats(const std::vector<ChatSummary>& chats) {
+    std::string records{};
+    for (const auto& chat : chats) {
+        const ChatKey key{chat.account, chat.id};
+        const auto it = stored_chats_.find(key);
+        const bool changed = it == stored_chats_.end()
+            || it->second.order != chat.order
+            || it->second.unread_count != chat.unread_count
+            || it->second.title != chat.title;
+        if (changed) {
+            write_chat(records, chat);
+            stored_chats_[key] = StoredChat{chat.order, chat.unread_count, chat.title};
+        }
+        if (chat.last_message.has_value()) {
+            stage_message(*chat.last_message, records);
+        }
+    }
+    submit(std::move(records));
+}
+
+void ChatCache::store_messages(const std::vector<Message>& messages) {
+    std::string records{};
+    for (const auto& message : messages) {
+        stage_message(message, records);
+    }
+    submit(std::move(records));
+}
+
+void ChatCache::store_message(const Message& message) {
+    std::string records{};
+    stage_message(message, records);
+    submit(std::move(records));
+}
+
+void ChatCache::flush() {
+    std::unique_lock lock(mutex_);
+    const auto target = submitted_batches_;
+    written_cv_.wait(lock, [this, target] { return written_batches_ >= target || !writer_.joinable(); });
+}
+
+// encodes `message` unless it is on disk already or older than everything the next load
+// keeps for its chat
+void ChatCache::stage_message(const Message& message, std::string& records) {
+    auto& ids = stored_messages_[ChatKey{message.account, message.chat_id}];
+    if (ids.size() >= kMaxMessagesPerChat && message.id < *ids.begin()) {
+        return;
+    }
+    if (!ids.insert(message.id).second) {
+        return;
+    }
+    if (ids.size() > kMaxMessagesPerChat) {
+        ids.erase(ids.begin());
+    }
+    write_message(records, message);
+}
+
+void ChatCache::submit(std::string records) {
+    if (records.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard lock(mutex_);
+        pending_ += records;
+        ++submitted_batches_;
+        if (!writer_.joinable()) {
+            writer_ = std::thread([this] { writer_loop(); });
+        }
+    }
+    wake_cv_.notify_one();
+}
+
+void ChatCache::writer_loop() {
+    std::string records{};
+    std::unique_lock lock(mutex_);
+    while (true) {
+        wake_cv_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+        if (pending_.empty()) {
+            break;
+        }
+
+        records.clear();
+        records.swap(pending_);
+        const auto batches = submitted_batches_;
+        lock.unlock();
+        write_records(records);
+        lock.lock();
+
+        written_batches_ = batches;
+        written_cv_.notify_all();
+    }
+}
+
+void ChatCache::write_records(const std::string& records) {
+    if (!open_for_append()) {
+        return;
+    }
+    out_.write(records.data(), static_cast<std::streamsize>(records.size()));
+    out_.flush();
+    file_size_ += records.size();
+
+    if (file_size_ < compact_at_) {
+        return;
+    }
+    out_.close();
+    auto contents = read_file(path_, kMaxMessagesPerChat);
+    auto compacted = contents.has_value()
+        ? compact(contents->snapshot)
+        : std::expected<void, std::string>{std::unexpected(contents.error())};
+    if (!compacted.has_value()) {
+        std::cerr << "Chat cache compaction failed: " << compacted.error() << std::endl;
+    }
+}
+
+auto ChatCache::open_for_append() -> bool {
+    if (out_.is_open()) {
+        return true;
+    }
+    if (append_failed_) {
+        return false;
+    }
+
+    std::error_code err{};
+    if (path_.has_parent_path()) {
+        std::filesystem::create_directories(path_.parent_path(), err);
+    }
+    const auto existing = std::filesystem::exists(path_, err) ? std::filesystem::file_size(path_, err) : 0;
+    file_size_ = err ? 0 : existing;
+
+    out_.open(path_, std::ios::binary | std::ios::app);
+    if (!out_.is_open()) {
+        append_failed_ = true;
+        std::cerr << "Chat cache disabled: failed to open " << path_.string() << std::endl;
+        return false;
+    }
+    if (file_size_ == 0) {
+        std::string header{};
+        write_header(header);
+        out_.write(header.data(), static_cast<std::streamsize>(header.size()));
+        file_size_ = header.size();
+    }
+    compact_at_ = next_compaction(file_size_);
+    return true;
+}
+
+auto ChatCache::compact(const ChatCacheSnapshot& snapshot) -> std::expected<void, std::string> {
+    out_.close();
+
+    auto temp_path = path_;
+    temp_path += ".tmp";
+
+    std::string contents{};
+    write_header(contents);
+    for (const auto& chat : snapshot.chats) {
+        write_chat(contents, chat);
+    }
+    for (const auto& [key, history] : snapshot.history) {
+        // oldest first so a later replay trims the same messages this one did
+        for (auto it = history.rbegin(); it != history.rend(); ++it) {
+            write_message(contents, *it);
+        }
+    }
+
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return std::unexpected("Failed to rewrite chat cache: " + temp_path.string());
+        }
+        out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        if (!out.flush()) {
+            return std::unexpected("Failed to write chat cache: " + temp_path.string());
+        }
+    }
+
+    std::error_code err{};
+    std::filesystem::rename(temp_path, path_, err);
+    if (err) {
+        return std::unexpected("Failed to replace chat cache: " + err.message());
+    }
+    return {};
+}
+
+void ChatCache::remember(const ChatCacheSnapshot& snapshot) {
+    stored_chats_.clear();
+    stored_messages_.clear();
+
+    for (const auto& chat : snapshot.chats) {
+        stored_chats_[ChatKey{chat.account, chat.id}] = StoredChat{chat.order, chat.unread_count, chat.title};
+    }
+    for (const auto& [key, history] : snapshot.history) {
+        auto& ids = stored_messages_[key];
+        for (const auto& message : history) {
+            ids.insert(message.id);
+        }
+    }
+}
+
+}  // namespace engine::cache
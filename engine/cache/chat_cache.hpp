@@ -0,0 +1,102 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "engine/backend/backend_types.hpp"
+
+namespace engine::cache {
+
+// what a previous session left on disk, already reconciled by id
+struct ChatCacheSnapshot {
+    std::vector<engine::backend::ChatSummary> chats{};  // by account, then highest order first
+    // newest first
+    std::unordered_map<engine::backend::ChatKey,
+                       std::vector<engine::backend::Message>,
+                       engine::backend::ChatKeyHash> history{};
+};
+
+// Append-only on-disk cache of chat summaries and recent messages, used to show the last
+// known chat list before the backend is ready.
+//
+// The file is a small header followed by length-prefixed records whose fixed part is laid
+// out exactly as the structs in chat_cache.cpp, so load() reads straight out of a read-only
+// mapping. Later records win over earlier ones with the same id; load() rewrites the file
+// once dead records dominate it.
+//
+// The store calls only encode records; a writer thread appends and flushes them, and
+// compacts the file again whenever it has doubled since the last rewrite.
+class ChatCache {
+public:
+    // keep at most this many messages per chat when loading and compacting
+    static constexpr std::size_t kMaxMessagesPerChat = 200;
+
+    explicit ChatCache(std::filesystem::path path);
+    ChatCache(const ChatCache&) = delete;
+    auto operator=(const ChatCache&) -> ChatCache& = delete;
+    ChatCache(ChatCache&&) = delete;
+    auto operator=(ChatCache&&) -> ChatCache& = delete;
+    ~ChatCache();
+
+    // a missing file is an empty snapshot, not an error; call before the first store
+    auto load() -> std::expected<ChatCacheSnapshot, std::string>;
+
+    // queue records for the writer thread; call them from one thread
+    void store_chats(const std::vector<engine::backend::ChatSummary>& chats);
+    void store_messages(const std::vector<engine::backend::Message>& messages);
+    void store_message(const engine::backend::Message& message);
+    // blocks until everything queued so far is on disk
+    void flush();
+
+private:
+    struct StoredChat {
+        std::int64_t order{0};
+        std::int32_t unread_count{0};
+        std::string title{};
+    };
+
+    auto open_for_append() -> bool;
+    auto compact(const ChatCacheSnapshot& snapshot) -> std::expected<void, std::string>;
+    void remember(const ChatCacheSnapshot& snapshot);
+    void stage_message(const engine::backend::Message& message, std::string& records);
+    void submit(std::string records);
+    void writer_loop();
+    void write_records(const std::string& records);
+
+    std::filesystem::path path_{};
+
+    // writer thread only, once it runs
+    std::ofstream out_{};
+    bool append_failed_{false};
+    std::uintmax_t file_size_{0};
+    std::uintmax_t compact_at_{0};
+
+    // encoded records waiting for the writer; a batch counts as written once it is flushed
+    std::mutex mutex_{};
+    std::condition_variable wake_cv_{};
+    std::condition_variable written_cv_{};
+    std::string pending_{};
+    std::uint64_t submitted_batches_{0};
+    std::uint64_t written_batches_{0};
+    bool stopping_{false};
+    std::thread writer_{};
+
+    // what is already on disk, so unchanged chats and known messages are not rewritten;
+    // message ids are kept for the newest kMaxMessagesPerChat of each chat only, the rest
+    // would be trimmed by the next load anyway
+    std::unordered_map<engine::backend::ChatKey, StoredChat, engine::backend::ChatKeyHash> stored_chats_{};
+    std::unordered_map<engine::backend::ChatKey,
+                       std::set<engine::backend::MessageId>,
+                       engine::backend::ChatKeyHash> stored_messages_{};
+};
+
+}  // namespace engine::cache
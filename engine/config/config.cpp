@@ -22,6 +22,18 @@ auto store() -> ConfigStore& {
     return instance;
 }
 
+auto backend_kind_name(BackendKind kind) -> std::string_view {
+    switch (kind) {
+        case BackendKind::Loopback:
+            return "loopback";
+        case BackendKind::Replay:
+            return "replay";
+        case BackendKind::Telegram:
+            break;
+    }
+    return "telegram";
+}
+
 auto write_config(const std::filesystem::path& config_path, const GameSettings& settings)
     -> std::expected<void, std::string> {
     if (config_path.has_parent_path()) {
@@ -55,6 +67,46 @@ auto write_config(const std::filesystem::path& config_path, const GameSettings&
     file << "save_credentials = " << (settings.telegram.save_credentials ? "true" : "false") << "\n";
     file << "\n";
 
+    for (const auto& account : settings.telegram.accounts) {
+        file << "[[telegram.accounts]]\n";
+        file << "name = \"" << account.name << "\"\n";
+        file << "database_directory = \"" << account.database_directory << "\"\n";
+        file << "\n";
+    }
+
+    if (settings.backend.kind != BackendKind::Telegram || !settings.backend.record_path.empty()) {
+        file << "[backend]\n";
+        file << "kind = \"" << backend_kind_name(settings.backend.kind) << "\"\n";
+        if (!settings.backend.record_path.empty()) {
+            file << "record_path = \"" << settings.backend.record_path << "\"\n";
+        }
+        file << "\n";
+    }
+
+    if (settings.backend.kind == BackendKind::Replay) {
+        file << "[backend.replay]\n";
+        file << "path = \"" << settings.backend.replay.path << "\"\n";
+        file << "speed = " << settings.backend.replay.speed << "\n";
+        file << "\n";
+    }
+
+    if (settings.backend.kind == BackendKind::Loopback) {
+        const auto& loopback = settings.backend.loopback;
+        file << "[backend.loopback]\n";
+        file << "seed = " << loopback.seed << "\n";
+        file << "chat_count = " << loopback.chat_count << "\n";
+        file << "history_size = " << loopback.history_size << "\n";
+        file << "messages_per_second = " << loopback.messages_per_second << "\n";
+        file << "message_size_min = " << loopback.message_size_min << "\n";
+        file << "message_size_max = " << loopback.message_size_max << "\n";
+        file << "\n";
+    }
+
+    file << "[history]\n";
+    file << "chat_budget_kb = " << settings.history.chat_budget_kb << "\n";
+    file << "total_budget_kb = " << settings.history.total_budget_kb << "\n";
+    file << "\n";
+
     if (!file.good()) {
         std::ostringstream oss;
         oss << "Failed to write default config file at '" << config_path.string() << "'.";
@@ -79,6 +131,222 @@ inline auto narrow_int(std::string_view key, int64_t value)
     return static_cast<int>(value);
 }
 
+inline auto narrow_non_negative_int(std::string_view key, int64_t value)
+    -> std::expected<int, std::string> {
+    if (value < 0 || value > static_cast<int64_t>(std::numeric_limits<int>::max())) {
+        std::ostringstream oss;
+        oss << "Config value '" << key << "' must be non-negative and fit in a 32-bit int.";
+        return std::unexpected(oss.str());
+    }
+
+    return static_cast<int>(value);
+}
+
+inline auto parse_backend_kind(std::string_view value) -> std::expected<BackendKind, std::string> {
+    if (value == "telegram") {
+        return BackendKind::Telegram;
+    }
+
+    if (value == "loopback") {
+        return BackendKind::Loopback;
+    }
+
+    if (value == "replay") {
+        return BackendKind::Replay;
+    }
+
+    std::ostringstream oss;
+    oss << "Unknown backend kind '" << value << "' (expected \"telegram\", \"loopback\" or \"replay\").";
+    return std::unexpected(oss.str());
+}
+
+inline auto parse_telegram_accounts(const toml::array& array)
+    -> std::expected<std::vector<TelegramAccountSettings>, std::string> {
+    std::vector<TelegramAccountSettings> accounts{};
+    accounts.reserve(array.size());
+
+    for (std::size_t i = 0; i < array.size(); ++i) {
+        const auto* entry = array.get_as<toml::table>(i);
+        if (entry == nullptr) {
+            return std::unexpected(std::string{"Config value 'telegram.accounts' must be an array of tables."});
+        }
+
+        TelegramAccountSettings account{};
+        account.name = (*entry)["name"].value_or(std::string{});
+        if (account.name.empty()) {
+            account.name = "account" + std::to_string(i + 1);
+        }
+        account.database_directory = (*entry)["database_directory"].value_or(std::string{});
+        if (account.database_directory.empty()) {
+            account.database_directory = "td_db_" + account.name;
+        }
+
+        for (const auto& other : accounts) {
+            if (other.database_directory == account.database_directory) {
+                std::ostringstream oss;
+                oss << "Telegram accounts '" << other.name << "' and '" << account.name
+                    << "' share database directory '" << account.database_directory << "'.";
+                return std::unexpected(oss.str());
+            }
+        }
+
+        accounts.push_back(std::move(account));
+    }
+
+    return accounts;
+}
+
+inline auto parse_loopback_settings(const toml::table& table,
+                                    LoopbackSettings defaults)
+    -> std::expected<LoopbackSettings, std::string> {
+    auto result = defaults;
+
+    if (const auto seed_node = table.get("seed")) {
+        if (const auto seed_value = seed_node->value<int64_t>()) {
+            if (*seed_value < 0) {
+                return std::unexpected(std::string{"Config value 'backend.loopback.seed' must not be negative."});
+            }
+            result.seed = static_cast<std::uint64_t>(*seed_value);
+        }
+    }
+
+    const std::pair<const char*, int LoopbackSettings::*> int_fields[] = {
+        {"chat_count", &LoopbackSettings::chat_count},
+        {"history_size", &LoopbackSettings::history_size},
+        {"messages_per_second", &LoopbackSettings::messages_per_second},
+        {"message_size_min", &LoopbackSettings::message_size_min},
+        {"message_size_max", &LoopbackSettings::message_size_max}
+    };
+
+    for (const auto& [key, field] : int_fields) {
+        const auto node = table.get(key);
+        if (!node) {
+            continue;
+        }
+
+        if (const auto value = node->value<int64_t>()) {
+            const std::string full_key = std::string{"backend.loopback."} + key;
+            auto value_expected = narrow_non_negative_int(full_key, *value);
+            if (!value_expected.has_value()) {
+                return std::unexpected(value_expected.error());
+            }
+            result.*field = value_expected.value();
+        }
+    }
+
+    if (result.chat_count == 0) {
+        return std::unexpected(std::string{"Config value 'backend.loopback.chat_count' must be positive."});
+    }
+
+    if (result.message_size_min > result.message_size_max) {
+        return std::unexpected(std::string{
+            "Config value 'backend.loopback.message_size_min' exceeds 'message_size_max'."
+        });
+    }
+
+    return result;
+}
+
+inline auto parse_replay_settings(const toml::table& table,
+                                  ReplaySettings defaults)
+    -> std::expected<ReplaySettings, std::string> {
+    auto result = defaults;
+
+    if (const auto path_node = table.get("path")) {
+        if (const auto path_value = path_node->value<std::string>()) {
+            result.path = *path_value;
+        }
+    }
+
+    if (const auto speed_node = table.get("speed")) {
+        if (const auto speed_value = speed_node->value<double>()) {
+            if (*speed_value < 0.0) {
+                return std::unexpected(std::string{"Config value 'backend.replay.speed' must not be negative."});
+            }
+            result.speed = *speed_value;
+        }
+    }
+
+    return result;
+}
+
+inline auto parse_backend_settings(const toml::table& table,
+                                   BackendSettings defaults)
+    -> std::expected<BackendSettings, std::string> {
+    auto result = defaults;
+
+    if (const auto kind_node = table.get("kind")) {
+        if (const auto kind_value = kind_node->value<std::string>()) {
+            auto kind_expected = parse_backend_kind(*kind_value);
+            if (!kind_expected.has_value()) {
+                return std::unexpected(kind_expected.error());
+            }
+            result.kind = kind_expected.value();
+        }
+    }
+
+    if (const auto loopback_table = table["loopback"].as_table()) {
+        auto loopback_expected = parse_loopback_settings(*loopback_table, result.loopback);
+        if (!loopback_expected.has_value()) {
+            return std::unexpected(loopback_expected.error());
+        }
+        result.loopback = loopback_expected.value();
+    }
+
+    if (const auto replay_table = table["replay"].as_table()) {
+        auto replay_expected = parse_replay_settings(*replay_table, result.replay);
+        if (!replay_expected.has_value()) {
+            return std::unexpected(replay_expected.error());
+        }
+        result.replay = replay_expected.value();
+    }
+
+    if (const auto record_node = table.get("record_path")) {
+        if (const auto record_value = record_node->value<std::string>()) {
+            result.record_path = *record_value;
+        }
+    }
+
+    if (result.kind == BackendKind::Replay && result.replay.path.empty()) {
+        return std::unexpected(std::string{"Config value 'backend.replay.path' is required for the replay backend."});
+    }
+
+    return result;
+}
+
+inline auto parse_history_settings(const toml::table& table,
+                                   HistorySettings defaults)
+    -> std::expected<HistorySettings, std::string> {
+    auto result = defaults;
+
+    const std::pair<const char*, int HistorySettings::*> int_fields[] = {
+        {"chat_budget_kb", &HistorySettings::chat_budget_kb},
+        {"total_budget_kb", &HistorySettings::total_budget_kb}
+    };
+
+    for (const auto& [key, field] : int_fields) {
+        const auto node = table.get(key);
+        if (!node) {
+            continue;
+        }
+
+        if (const auto value = node->value<int64_t>()) {
+            const std::string full_key = std::string{"history."} + key;
+            auto value_expected = narrow_non_negative_int(full_key, *value);
+            if (!value_expected.has_value()) {
+                return std::unexpected(value_expected.error());
+            }
+            result.*field = value_expected.value();
+        }
+    }
+
+    if (result.chat_budget_kb != 0 && result.total_budget_kb != 0 && result.chat_budget_kb > result.total_budget_kb) {
+        return std::unexpected(std::string{"Config value 'history.chat_budget_kb' exceeds 'total_budget_kb'."});
+    }
+
+    return result;
+}
+
 inline auto parse_render_settings(const toml::table& table,
                                   RenderSettings defaults)
     -> std::expected<RenderSettings, std::string> {
@@ -164,6 +432,31 @@ auto ConfigService::load(std::string_view path) -> std::expected<void, std::stri
                     config.telegram.save_credentials = *save_value;
                 }
             }
+            if (const auto accounts_array = telegram_table->get_as<toml::array>("accounts")) {
+                auto accounts_expected = parse_telegram_accounts(*accounts_array);
+                if (!accounts_expected.has_value()) {
+                    return std::unexpected(accounts_expected.error());
+                }
+                config.telegram.accounts = std::move(accounts_expected.value());
+            }
+        }
+
+        if (const auto backend_table = table["backend"].as_table()) {
+            auto backend_expected = parse_backend_settings(*backend_table, config.backend);
+            if (!backend_expected.has_value()) {
+                return std::unexpected(backend_expected.error());
+            }
+
+            config.backend = backend_expected.value();
+        }
+
+        if (const auto history_table = table["history"].as_table()) {
+            auto history_expected = parse_history_settings(*history_table, config.history);
+            if (!history_expected.has_value()) {
+                return std::unexpected(history_expected.error());
+            }
+
+            config.history = history_expected.value();
         }
 
         cfg_store.config = config;
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <expected>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace engine::config {
 
@@ -11,15 +13,57 @@ struct RenderSettings {
     int target_height{0};
 };
 
+// one TDLib client; every account needs its own database directory
+struct TelegramAccountSettings {
+    std::string name{};
+    std::string database_directory{};
+};
+
 struct TelegramSettings {
     int api_id{0};
     std::string api_hash{};
     bool save_credentials{true};
+    // empty means a single account using the legacy "td_db" directory
+    std::vector<TelegramAccountSettings> accounts{};
+};
+
+enum class BackendKind { Telegram, Loopback, Replay };
+
+// synthetic traffic for the loopback backend; every value is reproducible from `seed`
+struct LoopbackSettings {
+    std::uint64_t seed{1};
+    int chat_count{16};
+    int history_size{500};
+    int messages_per_second{1000};
+    int message_size_min{8};
+    int message_size_max{256};
+};
+
+// plays back a file written through `backend.record_path`
+struct ReplaySettings {
+    std::string path{};
+    double speed{1.0};  // 2.0 replays twice as fast; 0 delivers everything as fast as possible
+};
+
+struct BackendSettings {
+    BackendKind kind{BackendKind::Telegram};
+    LoopbackSettings loopback{};
+    ReplaySettings replay{};
+    // when set, every backend event of the session is recorded to this file
+    std::string record_path{};
+};
+
+// memory the in-memory chat histories may use, in KiB; 0 lifts the limit
+struct HistorySettings {
+    int chat_budget_kb{2048};
+    int total_budget_kb{32768};
 };
 
 struct GameSettings {
     RenderSettings render{};
     TelegramSettings telegram{};
+    BackendSettings backend{};
+    HistorySettings history{};
 };
 
 inline constexpr RenderSettings DEFAULT_RENDER_SETTINGS{
@@ -29,7 +73,9 @@ inline constexpr RenderSettings DEFAULT_RENDER_SETTINGS{
 
 inline constexpr GameSettings DEFAULT_GAME_SETTINGS{
     .render = DEFAULT_RENDER_SETTINGS,
-    .telegram = TelegramSettings{}
+    .telegram = TelegramSettings{},
+    .backend = BackendSettings{},
+    .history = HistorySettings{}
 };
 
 class ConfigService {
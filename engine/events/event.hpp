@@ -1,11 +1,11 @@
 #pragma once
 
 #include <chrono>
-#include <string>
 #include <variant>
 #include <vector>
 
 #include "engine/backend/backend_types.hpp"
+#include "engine/events/event_sources.hpp"
 
 namespace engine::events {
 
@@ -20,13 +20,41 @@ using EventPayload = std::variant<
     std::monostate,
     engine::backend::BackendStatus,
     std::vector<engine::backend::ChatSummary>,
-    engine::backend::ChatHistory,
+    engine::backend::ChatHistoryPtr,
     engine::backend::Message>;
 
+// the event id each payload type travels under; typed channels are keyed by payload type
+template <typename Payload>
+struct EventTraits;
+
+template <>
+struct EventTraits<engine::backend::BackendStatus> {
+    static constexpr EventId id = EventId::BackendStatus;
+};
+
+template <>
+struct EventTraits<std::vector<engine::backend::ChatSummary>> {
+    static constexpr EventId id = EventId::BackendChatList;
+};
+
+template <>
+struct EventTraits<engine::backend::ChatHistoryPtr> {
+    static constexpr EventId id = EventId::BackendChatHistory;
+};
+
+template <>
+struct EventTraits<engine::backend::Message> {
+    static constexpr EventId id = EventId::BackendNewMessage;
+};
+
 struct Event {
     EventId id{EventId::BackendStatus};
-    std::string source{};
+    SourceId source{0};
+    engine::backend::AccountId account{0};
     std::chrono::steady_clock::time_point timestamp{std::chrono::steady_clock::now()};
+    // stamped by EventService on emit, increasing per producer thread, so of two events of
+    // one account the lower number was emitted first whatever order they are handled in
+    std::uint64_t sequence{0};
     EventPayload payload{};
 };
 
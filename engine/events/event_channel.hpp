@@ -0,0 +1,67 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "engine/events/event.hpp"
+
+namespace engine::events {
+
+// Handlers for one payload type. The handler list is copy-on-write: subscribe and
+// unsubscribe build a new list under a writer mutex and publish it atomically, so
+// publish() only takes a reference to the current list and never allocates or waits on
+// the writer mutex. It is not lock-free everywhere: libstdc++ implements
+// std::atomic<std::shared_ptr> with an internal lock held for the load.
+template <typename Payload>
+class EventChannel {
+public:
+    using Handler = std::function<void(const Event&, const Payload&)>;
+
+    EventChannel() = default;
+    EventChannel(const EventChannel&) = delete;
+    auto operator=(const EventChannel&) -> EventChannel& = delete;
+    EventChannel(EventChannel&&) = delete;
+    auto operator=(EventChannel&&) -> EventChannel& = delete;
+    ~EventChannel() = default;
+
+    void add(std::size_t token, Handler handler) {
+        std::lock_guard lock(write_mutex_);
+        auto next = std::make_shared<std::vector<Entry>>(*handlers_.load());
+        next->push_back(Entry{token, std::move(handler)});
+        handlers_.store(std::move(next));
+    }
+
+    void remove(std::size_t token) {
+        std::lock_guard lock(write_mutex_);
+        auto next = std::make_shared<std::vector<Entry>>(*handlers_.load());
+        std::erase_if(*next, [token](const Entry& entry) { return entry.token == token; });
+        handlers_.store(std::move(next));
+    }
+
+    // handlers added or removed while publishing take effect from the next event
+    void publish(const Event& event, const Payload& payload) const {
+        const auto handlers = handlers_.load();
+        for (const auto& entry : *handlers) {
+            if (entry.handler) {
+                entry.handler(event, payload);
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        std::size_t token{0};
+        Handler handler{};
+    };
+
+    std::mutex write_mutex_{};
+    std::atomic<std::shared_ptr<const std::vector<Entry>>> handlers_{std::make_shared<const std::vector<Entry>>()};
+};
+
+}  // namespace engine::events
@@ -0,0 +1,380 @@
+#include "engine/events/event_recording.hpp"
+
+#include <array>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "engine/backend/sender_names.hpp"
+
+namespace engine::events {
+
+namespace {
+
+using engine::backend::AccountId;
+using engine::backend::BackendStatus;
+using engine::backend::BackendStatusKind;
+using engine::backend::ChatHistory;
+using engine::backend::ChatSummary;
+using engine::backend::Message;
+using engine::backend::SenderId;
+using engine::backend::TextArena;
+
+constexpr std::array<char, 4> kMagic{'L', 'N', 'G', 'R'};
+constexpr std::uint32_t kVersion = 2;
+// the writer hands its buffer to the file once it grows past this
+constexpr std::size_t kWriteChunk = 64U * 1024U;
+
+// on-disk layout; native endianness, recordings are replayed on the machine class that
+// wrote them
+struct FileHeader {
+    std::array<char, 4> magic{};
+    std::uint32_t version{0};
+};
+
+// `size` covers the payload that follows
+struct RecordHeader {
+    std::uint32_t size{0};
+    std::uint32_t id{0};
+    std::uint32_t account{0};
+    std::uint32_t reserved{0};
+    std::int64_t offset_us{0};
+};
+
+static_assert(std::is_trivially_copyable_v<FileHeader> && sizeof(FileHeader) == 8);
+static_assert(std::is_trivially_copyable_v<RecordHeader> && sizeof(RecordHeader) == 24);
+
+class Writer {
+public:
+    explicit Writer(std::string& out)
+        : out_{&out} {}
+
+    template <typename T>
+    void put(T value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto* bytes = reinterpret_cast<const char*>(&value);
+        out_->append(bytes, sizeof(T));
+    }
+
+    void put_string(std::string_view value) {
+        put(static_cast<std::uint32_t>(value.size()));
+        out_->append(value);
+    }
+
+    void put_message(const Message& message) {
+        put(message.id);
+        put(message.chat_id);
+        put(message.account);
+        put(static_cast<std::uint8_t>(message.sender.kind));
+        put(message.sender.id);
+        put(message.timestamp);
+        put_string(message.text.view());
+        put_string(engine::backend::SenderNames::lookup(message.sender));
+    }
+
+    void put_chat(const ChatSummary& chat) {
+        put(chat.id);
+        put(chat.account);
+        put(chat.order);
+        put(chat.unread_count);
+        put_string(chat.title);
+        put(static_cast<std::uint8_t>(chat.last_message.has_value() ? 1 : 0));
+        if (chat.last_message.has_value()) {
+            put_message(*chat.last_message);
+        }
+    }
+
+private:
+    std::string* out_{nullptr};
+};
+
+// every read checks the remaining size; a short record leaves the reader failed
+class Reader {
+public:
+    Reader(std::string_view data, TextArena& arena)
+        : data_{data},
+          arena_{&arena} {}
+
+    [[nodiscard]] auto failed() const noexcept -> bool { return failed_; }
+
+    template <typename T>
+    auto get() -> T {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value{};
+        if (failed_ || data_.size() < sizeof(T)) {
+            failed_ = true;
+            return value;
+        }
+        std::memcpy(&value, data_.data(), sizeof(T));
+        data_.remove_prefix(sizeof(T));
+        return value;
+    }
+
+    auto get_string() -> std::string_view {
+        const auto size = get<std::uint32_t>();
+        if (failed_ || data_.size() < size) {
+            failed_ = true;
+            return {};
+        }
+        const auto value = data_.substr(0, size);
+        data_.remove_prefix(size);
+        return value;
+    }
+
+    auto get_message() -> Message {
+        Message message{};
+        message.id = get<engine::backend::MessageId>();
+        message.chat_id = get<engine::backend::ChatId>();
+        message.account = get<AccountId>();
+        const auto kind = engine::backend::sender_kind_from(get<std::uint8_t>());
+        if (!kind.has_value()) {
+            failed_ = true;
+            return message;
+        }
+        message.sender.kind = *kind;
+        message.sender.id = get<std::int64_t>();
+        message.timestamp = get<engine::backend::Timestamp>();
+        message.text = arena_->append(get_string());
+        const auto sender_name = get_string();
+        if (!failed_ && !sender_name.empty()) {
+            engine::backend::SenderNames::assign(message.sender, sender_name);
+        }
+        return message;
+    }
+
+    auto get_chat() -> ChatSummary {
+        ChatSummary chat{};
+        chat.id = get<engine::backend::ChatId>();
+        chat.account = get<AccountId>();
+        chat.order = get<std::int64_t>();
+        chat.unread_count = get<std::int32_t>();
+        chat.title = std::string{get_string()};
+        if (get<std::uint8_t>() != 0) {
+            chat.last_message = get_message();
+        }
+        return chat;
+    }
+
+private:
+    std::string_view data_{};
+    TextArena* arena_{nullptr};
+    bool failed_{false};
+};
+
+void encode_payload(Writer& writer, const EventPayload& payload) {
+    std::visit(
+        [&writer](const auto& value) {
+            using T = std::decay_t<decltype(value)>;
+            if constexpr (std::is_same_v<T, BackendStatus>) {
+                writer.put(static_cast<std::uint32_t>(value.kind));
+                writer.put(value.account);
+                writer.put_string(value.detail);
+            } else if constexpr (std::is_same_v<T, std::vector<ChatSummary>>) {
+                writer.put(static_cast<std::uint32_t>(value.size()));
+                for (const auto& chat : value) {
+                    writer.put_chat(chat);
+                }
+            } else if constexpr (std::is_same_v<T, engine::backend::ChatHistoryPtr>) {
+                const ChatHistory empty{};
+                const auto& history = value != nullptr ? *value : empty;
+                writer.put(history.chat_id);
+                writer.put(history.account);
+                writer.put(history.before);
+                writer.put(static_cast<std::uint8_t>(history.append ? 1 : 0));
+                writer.put(static_cast<std::uint8_t>(history.complete ? 1 : 0));
+                writer.put(static_cast<std::uint32_t>(history.messages.size()));
+                for (const auto& message : history.messages) {
+                    writer.put_message(message);
+                }
+            } else if constexpr (std::is_same_v<T, Message>) {
+                writer.put_message(value);
+            }
+        },
+        payload
+    );
+}
+
+auto decode_payload(EventId id, Reader& reader) -> EventPayload {
+    switch (id) {
+        case EventId::BackendStatus: {
+            BackendStatus status{};
+            status.kind = static_cast<BackendStatusKind>(reader.get<std::uint32_t>());
+            status.account = reader.get<AccountId>();
+            status.detail = std::string{reader.get_string()};
+            return status;
+        }
+        case EventId::BackendChatList: {
+            const auto count = reader.get<std::uint32_t>();
+            std::vector<ChatSummary> chats{};
+            for (std::uint32_t i = 0; i < count && !reader.failed(); ++i) {
+                chats.push_back(reader.get_chat());
+            }
+            return chats;
+        }
+        case EventId::BackendChatHistory: {
+            auto history = std::make_shared<ChatHistory>();
+            history->chat_id = reader.get<engine::backend::ChatId>();
+            history->account = reader.get<AccountId>();
+            history->before = reader.get<engine::backend::MessageId>();
+            history->append = reader.get<std::uint8_t>() != 0;
+            history->complete = reader.get<std::uint8_t>() != 0;
+            const auto count = reader.get<std::uint32_t>();
+            for (std::uint32_t i = 0; i < count && !reader.failed(); ++i) {
+                history->messages.push_back(reader.get_message());
+            }
+            return engine::backend::ChatHistoryPtr{std::move(history)};
+        }
+        case EventId::BackendNewMessage:
+            return reader.get_message();
+    }
+    return std::monostate{};
+}
+
+}  // namespace
+
+EventRecorder::EventRecorder(std::filesystem::path path)
+    : path_{std::move(path)} {}
+
+EventRecorder::~EventRecorder() {
+    flush();
+}
+
+auto EventRecorder::open() -> std::expected<void, std::string> {
+    std::lock_guard lock(mutex_);
+
+    if (path_.has_parent_path()) {
+        std::error_code err{};
+        std::filesystem::create_directories(path_.parent_path(), err);
+    }
+
+    out_.open(path_, std::ios::binary | std::ios::trunc);
+    if (!out_) {
+        failed_ = true;
+        return std::unexpected("Failed to open event recording '" + path_.string() + "'.");
+    }
+
+    FileHeader header{};
+    header.magic = kMagic;
+    header.version = kVersion;
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    started_ = std::chrono::steady_clock::now();
+    failed_ = false;
+    return {};
+}
+
+void EventRecorder::record(const Event& event) {
+    std::lock_guard lock(mutex_);
+    if (failed_ || !out_.is_open()) {
+        return;
+    }
+    encode(event);
+}
+
+void EventRecorder::record_batch(std::span<const Event> events) {
+    std::lock_guard lock(mutex_);
+    if (!out_.is_open()) {
+        return;
+    }
+    for (const auto& event : events) {
+        if (failed_) {
+            return;
+        }
+        encode(event);
+    }
+}
+
+// caller holds mutex_
+void EventRecorder::encode(const Event& event) {
+    const auto header_at = buffer_.size();
+    buffer_.resize(header_at + sizeof(RecordHeader));
+
+    Writer writer{buffer_};
+    encode_payload(writer, event.payload);
+
+    RecordHeader header{};
+    header.size = static_cast<std::uint32_t>(buffer_.size() - header_at - sizeof(RecordHeader));
+    header.id = static_cast<std::uint32_t>(event.id);
+    header.account = event.account;
+    header.offset_us = std::chrono::duration_cast<std::chrono::microseconds>(event.timestamp - started_).count();
+    std::memcpy(buffer_.data() + header_at, &header, sizeof(header));
+
+    if (buffer_.size() >= kWriteChunk) {
+        write_buffer();
+    }
+}
+
+void EventRecorder::flush() {
+    std::lock_guard lock(mutex_);
+    write_buffer();
+    if (out_.is_open()) {
+        out_.flush();
+    }
+}
+
+// expects mutex_ to be held
+void EventRecorder::write_buffer() {
+    if (buffer_.empty() || !out_.is_open()) {
+        return;
+    }
+
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+    if (!out_) {
+        failed_ = true;
+    }
+}
+
+auto load_recording(const std::filesystem::path& path) -> std::expected<std::vector<RecordedEvent>, std::string> {
+    std::ifstream in{path, std::ios::binary};
+    if (!in) {
+        return std::unexpected("Failed to open event recording '" + path.string() + "'.");
+    }
+    const std::string data{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+
+    FileHeader header{};
+    if (data.size() < sizeof(header)) {
+        return std::unexpected("Event recording '" + path.string() + "' is truncated.");
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != kMagic || header.version != kVersion) {
+        return std::unexpected("Event recording '" + path.string() + "' has an unknown format.");
+    }
+
+    std::vector<RecordedEvent> events{};
+    TextArena arena{};
+    std::string_view rest{data};
+    rest.remove_prefix(sizeof(header));
+
+    while (rest.size() >= sizeof(RecordHeader)) {
+        RecordHeader record{};
+        std::memcpy(&record, rest.data(), sizeof(record));
+        rest.remove_prefix(sizeof(record));
+        if (rest.size() < record.size) {
+            break;
+        }
+
+        const auto id = static_cast<EventId>(record.id);
+        Reader reader{rest.substr(0, record.size), arena};
+        auto payload = decode_payload(id, reader);
+        rest.remove_prefix(record.size);
+        if (reader.failed() || std::holds_alternative<std::monostate>(payload)) {
+            continue;
+        }
+
+        events.push_back(RecordedEvent{
+            .id = id,
+            .account = record.account,
+            .offset = std::chrono::microseconds{record.offset_us},
+            .payload = std::move(payload)
+        });
+    }
+
+    return events;
+}
+
+}  // namespace engine::events
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <expected>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "engine/events/event.hpp"
+
+namespace engine::events {
+
+// one event read back from a recording
+struct RecordedEvent {
+    EventId id{EventId::BackendStatus};
+    engine::backend::AccountId account{0};
+    std::chrono::microseconds offset{0};  // since the recording started
+    EventPayload payload{};
+};
+
+// Appends every event handed to record() to a compact binary file: a small header, then
+// one length-prefixed record per event holding its id, account, time offset and payload.
+// Sender display names travel with each message so a replay shows the same names.
+class EventRecorder {
+public:
+    explicit EventRecorder(std::filesystem::path path);
+    EventRecorder(const EventRecorder&) = delete;
+    auto operator=(const EventRecorder&) -> EventRecorder& = delete;
+    EventRecorder(EventRecorder&&) = delete;
+    auto operator=(EventRecorder&&) -> EventRecorder& = delete;
+    ~EventRecorder();
+
+    // truncates an existing file
+    auto open() -> std::expected<void, std::string>;
+    // any thread
+    void record(const Event& event);
+    // any thread; takes the lock once for the whole batch
+    void record_batch(std::span<const Event> events);
+    void flush();
+
+private:
+    void encode(const Event& event);
+    void write_buffer();
+
+    std::filesystem::path path_{};
+    std::mutex mutex_{};
+    std::ofstream out_{};
+    std::string buffer_{};
+    std::chrono::steady_clock::time_point started_{};
+    bool failed_{false};
+};
+
+// Reads a whole recording. A torn tail (the writer died mid-record) ends the list instead
+// of failing it. Recorded sender names are registered with SenderNames.
+auto load_recording(const std::filesystem::path& path) -> std::expected<std::vector<RecordedEvent>, std::string>;
+
+}  // namespace engine::events
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
+
+namespace engine::events {
+
+// Bounded multi-producer / single-consumer ring. Every slot carries a sequence number
+// (Vyukov's bounded queue), so producers claim slots with one CAS on the tail and never
+// wait on each other or on the consumer; a full ring makes try_push fail instead.
+template <typename T>
+class EventRing {
+public:
+    // rounded up to a power of two
+    explicit EventRing(std::size_t capacity)
+        : capacity_{std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity)},
+          mask_{capacity_ - 1},
+          slots_{std::make_unique<Slot[]>(capacity_)} {
+        for (std::size_t i = 0; i < capacity_; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    EventRing(const EventRing&) = delete;
+    auto operator=(const EventRing&) -> EventRing& = delete;
+    EventRing(EventRing&&) = delete;
+    auto operator=(EventRing&&) -> EventRing& = delete;
+    ~EventRing() = default;
+
+    // any thread; `value` is moved from only when this returns true
+    auto try_push(T& value) -> bool {
+        auto position = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            auto& slot = slots_[position & mask_];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto lag = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+
+            if (lag == 0) {
+                if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.value = std::move(value);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                return false;  // the consumer has not freed this slot yet
+            } else {
+                position = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // any thread; claims as many free slots as there are, up to values.size(), with one CAS
+    // and moves that many values in order. Returns how many were pushed.
+    auto try_push_batch(std::span<T> values) -> std::size_t {
+        if (values.empty()) {
+            return 0;
+        }
+        auto position = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            std::size_t free = 0;
+            for (; free < values.size(); ++free) {
+                const auto sequence = slots_[(position + free) & mask_].sequence.load(std::memory_order_acquire);
+                if (sequence != position + free) {
+                    break;
+                }
+            }
+
+            if (free == 0) {
+                const auto sequence = slots_[position & mask_].sequence.load(std::memory_order_acquire);
+                if (static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position) < 0) {
+                    return 0;  // full
+                }
+                position = tail_.load(std::memory_order_relaxed);
+                continue;
+            }
+
+            if (tail_.compare_exchange_weak(position, position + free, std::memory_order_relaxed)) {
+                for (std::size_t i = 0; i < free; ++i) {
+                    auto& slot = slots_[(position + i) & mask_];
+                    slot.value = std::move(values[i]);
+                    slot.sequence.store(position + i + 1, std::memory_order_release);
+                }
+                return free;
+            }
+        }
+    }
+
+    // consumer thread only
+    auto try_pop(T& out) -> bool {
+        const auto position = head_.load(std::memory_order_relaxed);
+        auto& slot = slots_[position & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+            return false;
+        }
+
+        out = std::move(slot.value);
+        slot.value = T{};
+        slot.sequence.store(position + capacity_, std::memory_order_release);
+        head_.store(position + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t { return capacity_; }
+
+    // exact on the consumer thread, a snapshot anywhere else
+    [[nodiscard]] auto size_approx() const noexcept -> std::size_t {
+        const auto head = head_.load(std::memory_order_relaxed);
+        const auto tail = tail_.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+private:
+    struct Slot {
+        std::atomic<std::size_t> sequence{0};
+        T value{};
+    };
+
+    static constexpr std::size_t kCacheLine = 64;
+
+    std::size_t capacity_{0};
+    std::size_t mask_{0};
+    std::unique_ptr<Slot[]> slots_{};
+    alignas(kCacheLine) std::atomic<std::size_t> tail_{0};
+    alignas(kCacheLine) std::atomic<std::size_t> head_{0};
+};
+
+}  // namespace engine::events
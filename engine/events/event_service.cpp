@@ -1,69 +1,318 @@
 #include "engine/events/event_service.hpp"
 
+#include "engine/events/event_recording.hpp"
+
 #include <algorithm>
+#include <iterator>
+#include <type_traits>
 #include <utility>
+#include <variant>
 
 namespace engine::events {
 
-auto EventService::subscribe(EventId id, Handler handler) -> Subscription {
-    const auto token = next_token_.fetch_add(1);
-    {
-        std::lock_guard lock(handlers_mutex_);
-        handlers_[id].push_back(HandlerEntry{token, std::move(handler)});
-    }
-    return Subscription{id, token};
+namespace {
+
+auto id_index(EventId id) -> std::size_t {
+    return static_cast<std::size_t>(id);
 }
 
+}  // namespace
+
+EventService::EventService(std::size_t ingress_capacity)
+    : ring_{ingress_capacity} {}
+
 void EventService::unsubscribe(const Subscription& subscription) {
-    std::lock_guard lock(handlers_mutex_);
-    auto it = handlers_.find(subscription.id);
-    if (it == handlers_.end()) {
-        return;
+    switch (subscription.id) {
+        case EventId::BackendStatus:
+            channel<engine::backend::BackendStatus>().remove(subscription.token);
+            break;
+        case EventId::BackendChatList:
+            channel<std::vector<engine::backend::ChatSummary>>().remove(subscription.token);
+            break;
+        case EventId::BackendChatHistory:
+            channel<engine::backend::ChatHistoryPtr>().remove(subscription.token);
+            break;
+        case EventId::BackendNewMessage:
+            channel<engine::backend::Message>().remove(subscription.token);
+            break;
     }
-    auto& entries = it->second;
-    entries.erase(
-        std::remove_if(
-            entries.begin(),
-            entries.end(),
-            [&subscription](const HandlerEntry& entry) { return entry.token == subscription.token; }
-        ),
-        entries.end()
-    );
+}
+
+void EventService::set_priority(EventId id, EventPriority priority) {
+    const auto index = id_index(id);
+    if (index < priorities_.size()) {
+        priorities_[index] = priority;
+    }
+}
+
+void EventService::set_overflow_policy(EventId id, OverflowPolicy policy) {
+    const auto index = id_index(id);
+    if (index < policies_.size()) {
+        policies_[index] = policy;
+    }
+}
+
+void EventService::record_to(EventRecorder* recorder) {
+    recorder_ = recorder;
 }
 
 void EventService::emit(Event event) {
-    std::lock_guard lock(queue_mutex_);
-    queue_.push_back(std::move(event));
+    event.sequence = next_sequence_.fetch_add(1, std::memory_order_relaxed);
+    if (recorder_ != nullptr) {
+        recorder_->record(event);
+    }
+    push(event);
+}
+
+void EventService::emit_batch(std::span<Event> events) {
+    auto sequence = next_sequence_.fetch_add(events.size(), std::memory_order_relaxed);
+    for (auto& event : events) {
+        event.sequence = sequence++;
+    }
+    if (recorder_ != nullptr) {
+        recorder_->record_batch(events);
+    }
+
+    std::size_t next = 0;
+    while (next < events.size()) {
+        // the run up to the first id with overflowed events pending goes to the ring at once
+        std::size_t run_end = next;
+        while (run_end < events.size() && !is_overflowing(events[run_end].id)) {
+            ++run_end;
+        }
+        next += ring_.try_push_batch(events.subspan(next, run_end - next));
+
+        // a full ring or an overflowing id: this one takes the single-event path
+        if (next < events.size()) {
+            push(events[next]);
+            ++next;
+        }
+    }
+}
+
+void EventService::push(Event& event) {
+    const auto policy = policy_of(event.id);
+
+    // an id with overflowed events pending keeps queueing behind them
+    if (is_overflowing(event.id) && try_overflow(event, policy)) {
+        overflowed_events_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (ring_.try_push(event)) {
+        return;
+    }
+
+    overflowed_events_.fetch_add(1, std::memory_order_relaxed);
+    if (try_overflow(event, policy)) {
+        return;
+    }
+
+    if (policy == OverflowPolicy::Drop) {
+        dropped_events_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    emit_blocking(event);
 }
 
 void EventService::dispatch() {
-    std::vector<Event> local_queue{};
-    {
-        std::lock_guard lock(queue_mutex_);
-        if (queue_.empty()) {
+    collect_emitted();
+
+    std::size_t dispatched = 0;
+    for (auto& lane : lanes_) {
+        while (!lane.empty()) {
+            const auto event = std::move(lane.front());
+            lane.pop_front();
+            publish(event);
+            ++dispatched;
+        }
+    }
+
+    stats_.last_dispatched = dispatched;
+    stats_.queue_depth = 0;
+}
+
+void EventService::dispatch(std::chrono::microseconds budget) {
+    collect_emitted();
+
+    const auto deadline = std::chrono::steady_clock::now() + budget;
+    std::size_t dispatched = 0;
+    std::size_t left = 0;
+
+    for (auto& lane : lanes_) {
+        while (!lane.empty()) {
+            if (dispatched > 0 && std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+            const auto event = std::move(lane.front());
+            lane.pop_front();
+            publish(event);
+            ++dispatched;
+        }
+        left += lane.size();
+    }
+
+    stats_.last_dispatched = dispatched;
+    stats_.queue_depth = left;
+    if (left > 0) {
+        ++stats_.deferred_dispatches;
+        stats_.deferred_events += left;
+    }
+}
+
+auto EventService::stats() const -> DispatchStats {
+    auto stats = stats_;
+    stats.queue_depth += ring_.size_approx();
+    stats.overflowed_events = overflowed_events_.load(std::memory_order_relaxed);
+    stats.coalesced_events = coalesced_events_.load(std::memory_order_relaxed);
+    stats.dropped_events = dropped_events_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+auto EventService::dropped_messages() const -> std::vector<ChatDrops> {
+    std::lock_guard lock(overflow_.mutex);
+    std::vector<ChatDrops> drops{};
+    drops.reserve(overflow_.merge_drops.size());
+    for (const auto& [chat, dropped] : overflow_.merge_drops) {
+        drops.push_back(ChatDrops{chat, dropped});
+    }
+    return drops;
+}
+
+auto EventService::is_overflowing(EventId id) const -> bool {
+    const auto index = id_index(id);
+    return index < kIdCount && overflowing_[index].load(std::memory_order_acquire);
+}
+
+auto EventService::policy_of(EventId id) const -> OverflowPolicy {
+    const auto index = id_index(id);
+    return index < policies_.size() ? policies_[index] : OverflowPolicy::Block;
+}
+
+auto EventService::try_overflow(Event& event, OverflowPolicy policy) -> bool {
+    const auto index = id_index(event.id);
+    if (index >= kIdCount) {
+        return false;
+    }
+
+    if (policy == OverflowPolicy::CoalesceLatest) {
+        std::lock_guard lock(overflow_.mutex);
+        auto [it, inserted] = overflow_.latest.try_emplace({event.id, event.account});
+        if (!inserted) {
+            coalesced_events_.fetch_add(1, std::memory_order_relaxed);
+        }
+        it->second = std::move(event);
+        overflowing_[index].store(true, std::memory_order_release);
+        return true;
+    }
+
+    if (policy == OverflowPolicy::MergePerChat) {
+        const auto* message = std::get_if<engine::backend::Message>(&event.payload);
+        if (message == nullptr) {
+            return false;
+        }
+
+        const engine::backend::ChatKey key{message->account, message->chat_id};
+        std::lock_guard lock(overflow_.mutex);
+        auto& pending = overflow_.merged[key];
+        pending.push_back(std::move(event));
+        if (pending.size() > kMaxMergedPerChat) {
+            // the oldest ones go and stay gone until the chat's history is fetched again;
+            // the per-chat count says which chats have gaps
+            pending.pop_front();
+            ++overflow_.merge_drops[key];
+            dropped_events_.fetch_add(1, std::memory_order_relaxed);
+        }
+        overflowing_[index].store(true, std::memory_order_release);
+        return true;
+    }
+
+    return false;
+}
+
+void EventService::emit_blocking(Event& event) {
+    const auto deadline = std::chrono::steady_clock::now() + kMaxEmitBlock;
+
+    while (!ring_.try_push(event)) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            // the main thread is not draining (e.g. it is joining the reactor); losing the
+            // event beats deadlocking on it
+            dropped_events_.fetch_add(1, std::memory_order_relaxed);
             return;
         }
-        local_queue.swap(queue_);
+
+        std::unique_lock lock(space_mutex_);
+        space_cv_.wait_for(lock, std::chrono::milliseconds{1});
     }
+}
 
-    for (const auto& event : local_queue) {
-        std::vector<HandlerEntry> handlers_copy{};
+void EventService::collect_emitted() {
+    const bool any_overflow = std::any_of(overflowing_.begin(), overflowing_.end(), [](const auto& flag) {
+        return flag.load(std::memory_order_acquire);
+    });
+
+    Event event{};
+    bool freed = false;
+    if (!any_overflow) {
+        while (ring_.try_pop(event)) {
+            to_lane(std::move(event));
+            freed = true;
+        }
+    } else {
+        // the ring and the overflow maps each hold part of the emit order, e.g. a status that
+        // fit in the ring after a list that was coalesced; the emit stamps restore it
+        while (ring_.try_pop(event)) {
+            collected_.push_back(std::move(event));
+            freed = true;
+        }
         {
-            std::lock_guard lock(handlers_mutex_);
-            auto it = handlers_.find(event.id);
-            if (it != handlers_.end()) {
-                handlers_copy = it->second;
+            std::lock_guard lock(overflow_.mutex);
+            for (auto& [key, latest] : overflow_.latest) {
+                collected_.push_back(std::move(latest));
+            }
+            overflow_.latest.clear();
+            for (auto& [chat, pending] : overflow_.merged) {
+                std::move(pending.begin(), pending.end(), std::back_inserter(collected_));
+            }
+            overflow_.merged.clear();
+            for (auto& flag : overflowing_) {
+                flag.store(false, std::memory_order_release);
             }
         }
 
-        for (const auto& entry : handlers_copy) {
-            if (entry.handler) {
-                entry.handler(event);
-            }
+        std::stable_sort(collected_.begin(), collected_.end(), [](const Event& lhs, const Event& rhs) {
+            return lhs.sequence < rhs.sequence;
+        });
+        for (auto& collected : collected_) {
+            to_lane(std::move(collected));
         }
+        collected_.clear();
+    }
+
+    if (freed) {
+        std::lock_guard lock(space_mutex_);
+        space_cv_.notify_all();
     }
 }
 
-}  // namespace engine::events
+void EventService::to_lane(Event event) {
+    const auto index = id_index(event.id);
+    const auto priority = index < priorities_.size() ? priorities_[index] : EventPriority::Normal;
+    lanes_[static_cast<std::size_t>(priority)].push_back(std::move(event));
+}
 
+// the payload alternative picks the channel, so handlers never inspect the variant
+void EventService::publish(const Event& event) {
+    std::visit(
+        [this, &event](const auto& payload) {
+            using Payload = std::decay_t<decltype(payload)>;
+            if constexpr (!std::is_same_v<Payload, std::monostate>) {
+                channel<Payload>().publish(event, payload);
+            }
+        },
+        event.payload
+    );
+}
 
+}  // namespace engine::events
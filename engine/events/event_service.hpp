@@ -1,51 +1,179 @@
 #pragma once
 
+#include <array>
 #include <atomic>
-#include <functional>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
 #include <mutex>
+#include <span>
+#include <tuple>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "engine/events/event.hpp"
+#include "engine/events/event_channel.hpp"
+#include "engine/events/event_ring.hpp"
 
 namespace engine::events {
 
+class EventRecorder;
+
+// Lanes are drained strictly in order. New messages share the bulk lane with histories so a
+// message never overtakes the history load it should land on top of. A status may overtake
+// older lists and histories of its own account; Event::sequence tells consumers which ones.
+enum class EventPriority : std::uint8_t { High = 0, Normal = 1, Bulk = 2 };
+
+// what emit() does with an event while the ingress ring is full
+enum class OverflowPolicy : std::uint8_t {
+    Block,           // wait for the main thread to make room, dropping after kMaxEmitBlock
+    Drop,            // discard and count
+    CoalesceLatest,  // keep only the newest event per id and account
+    MergePerChat     // keep new messages per chat, capped at kMaxMergedPerChat
+};
+
+struct DispatchStats {
+    std::size_t queue_depth{0};        // events still waiting, including not yet dispatched emits
+    std::size_t last_dispatched{0};    // events handled by the latest dispatch call
+    std::uint64_t deferred_dispatches{0};  // dispatch calls that ran out of budget
+    std::uint64_t deferred_events{0};      // events carried over to a later frame, summed
+    std::uint64_t overflowed_events{0};    // emits that found the ring full
+    std::uint64_t coalesced_events{0};     // overflowed events replaced by a newer one
+    std::uint64_t dropped_events{0};       // events lost to Drop, a block timeout or a merge cap
+};
+
+// new messages a chat lost to the MergePerChat cap; nothing refetches them on its own
+struct ChatDrops {
+    engine::backend::ChatKey chat{};
+    std::uint64_t dropped{0};
+};
+
 class EventService {
 public:
-    using Handler = std::function<void(const Event&)>;
+    template <typename Payload>
+    using Handler = typename EventChannel<Payload>::Handler;
 
     struct Subscription {
         EventId id{EventId::BackendStatus};
         std::size_t token{0};
     };
 
-    EventService() = default;
+    static constexpr std::size_t kDefaultIngressCapacity = 4096;
+    static constexpr std::size_t kMaxMergedPerChat = 256;
+    static constexpr std::chrono::milliseconds kMaxEmitBlock{250};
+
+    explicit EventService(std::size_t ingress_capacity = kDefaultIngressCapacity);
     EventService(const EventService&) = delete;
     auto operator=(const EventService&) -> EventService& = delete;
     EventService(EventService&&) = delete;
     auto operator=(EventService&&) -> EventService& = delete;
     ~EventService() = default;
 
-    [[nodiscard]] auto subscribe(EventId id, Handler handler) -> Subscription;
+    // handlers receive the payload already unpacked, e.g.
+    // subscribe<engine::backend::Message>([](const Event& event, const Message& message) { ... })
+    template <typename Payload>
+    [[nodiscard]] auto subscribe(Handler<Payload> handler) -> Subscription {
+        const auto token = next_token_.fetch_add(1);
+        channel<Payload>().add(token, std::move(handler));
+        return Subscription{EventTraits<Payload>::id, token};
+    }
     void unsubscribe(const Subscription& subscription);
 
+    // priorities are read by dispatch() and policies by emit(); set both before the
+    // producers start
+    void set_priority(EventId id, EventPriority priority);
+    void set_overflow_policy(EventId id, OverflowPolicy policy);
+    // every emitted event is also handed to `recorder` (null stops recording); set it before
+    // the producers start
+    void record_to(EventRecorder* recorder);
+
+    // any thread; never blocks unless the ring is full and the id's policy is Block. Stamps
+    // Event::sequence first.
     void emit(Event event);
+    // emits in order, moving from every element; claims ring slots for a run of events with
+    // one CAS and records the whole batch under one lock
+    void emit_batch(std::span<Event> events);
+    // handles everything queued
     void dispatch();
+    // handles queued events by priority until `budget` is spent and leaves the rest for the
+    // next call; at least one event is handled per call so every lane keeps moving
+    void dispatch(std::chrono::microseconds budget);
+    // call from the dispatching thread
+    [[nodiscard]] auto stats() const -> DispatchStats;
+    // any thread; per chat, in no particular order
+    [[nodiscard]] auto dropped_messages() const -> std::vector<ChatDrops>;
 
 private:
-    struct HandlerEntry {
-        std::size_t token{0};
-        Handler handler{};
+    static constexpr std::size_t kLaneCount = 3;
+    static constexpr std::size_t kIdCount = 5;
+
+    // events that did not fit in the ring; once an id has anything here, later events with
+    // that id follow it so they cannot overtake it
+    struct Overflow {
+        mutable std::mutex mutex{};
+        std::map<std::pair<EventId, engine::backend::AccountId>, Event> latest{};
+        std::unordered_map<engine::backend::ChatKey, std::deque<Event>, engine::backend::ChatKeyHash> merged{};
+        std::unordered_map<engine::backend::ChatKey, std::uint64_t, engine::backend::ChatKeyHash> merge_drops{};
     };
 
-    std::mutex handlers_mutex_{};
-    std::unordered_map<EventId, std::vector<HandlerEntry>> handlers_{};
+    template <typename Payload>
+    auto channel() -> EventChannel<Payload>& {
+        return std::get<EventChannel<Payload>>(channels_);
+    }
+
+    [[nodiscard]] auto policy_of(EventId id) const -> OverflowPolicy;
+    [[nodiscard]] auto is_overflowing(EventId id) const -> bool;
+    // emit() after recording
+    void push(Event& event);
+    auto try_overflow(Event& event, OverflowPolicy policy) -> bool;
+    void emit_blocking(Event& event);
+    void collect_emitted();
+    void to_lane(Event event);
+    void publish(const Event& event);
+
+    std::tuple<EventChannel<engine::backend::BackendStatus>,
+               EventChannel<std::vector<engine::backend::ChatSummary>>,
+               EventChannel<engine::backend::ChatHistoryPtr>,
+               EventChannel<engine::backend::Message>> channels_{};
     std::atomic<std::size_t> next_token_{1};
 
-    std::mutex queue_mutex_{};
-    std::vector<Event> queue_{};
-};
+    EventRing<Event> ring_;
+    std::array<OverflowPolicy, kIdCount> policies_{
+        OverflowPolicy::Block,           // unused id 0
+        OverflowPolicy::CoalesceLatest,  // BackendStatus
+        OverflowPolicy::CoalesceLatest,  // BackendChatList: each list replaces its account's slice
+        OverflowPolicy::Block,           // BackendChatHistory
+        OverflowPolicy::MergePerChat     // BackendNewMessage
+    };
+    Overflow overflow_{};
+    EventRecorder* recorder_{nullptr};
+    std::array<std::atomic<bool>, kIdCount> overflowing_{};
 
-}  // namespace engine::events
+    // producers blocked on a full ring wait here for the next collect
+    std::mutex space_mutex_{};
+    std::condition_variable space_cv_{};
 
+    std::atomic<std::uint64_t> overflowed_events_{0};
+    std::atomic<std::uint64_t> coalesced_events_{0};
+    std::atomic<std::uint64_t> dropped_events_{0};
+    // 0 is left for events that never went through emit()
+    std::atomic<std::uint64_t> next_sequence_{1};
 
+    // dispatching thread only
+    std::array<EventPriority, kIdCount> priorities_{
+        EventPriority::Normal,  // unused id 0
+        EventPriority::High,    // BackendStatus
+        EventPriority::Normal,  // BackendChatList
+        EventPriority::Bulk,    // BackendChatHistory
+        EventPriority::Bulk     // BackendNewMessage
+    };
+    std::array<std::deque<Event>, kLaneCount> lanes_{};
+    // reused by collect_emitted() to merge the ring with the overflow maps
+    std::vector<Event> collected_{};
+    DispatchStats stats_{};
+};
+
+}  // namespace engine::events
@@ -0,0 +1,45 @@
+#include "engine/events/event_sources.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+namespace engine::events {
+
+namespace {
+
+struct SourceTable {
+    std::shared_mutex mutex{};
+    // a deque never moves its elements, so handed-out views stay valid; index 0 is ""
+    std::deque<std::string> names{std::string{}};
+};
+
+auto table() -> SourceTable& {
+    static SourceTable sources{};
+    return sources;
+}
+
+}  // namespace
+
+auto EventSources::intern(std::string_view name) -> SourceId {
+    auto& sources = table();
+    std::unique_lock lock(sources.mutex);
+
+    const auto it = std::find(sources.names.begin(), sources.names.end(), name);
+    if (it != sources.names.end()) {
+        return static_cast<SourceId>(it - sources.names.begin());
+    }
+
+    sources.names.emplace_back(name);
+    return static_cast<SourceId>(sources.names.size() - 1);
+}
+
+auto EventSources::name(SourceId id) -> std::string_view {
+    auto& sources = table();
+    std::shared_lock lock(sources.mutex);
+    return id < sources.names.size() ? std::string_view{sources.names[id]} : std::string_view{};
+}
+
+}  // namespace engine::events
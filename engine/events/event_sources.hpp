@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace engine::events {
+
+using SourceId = std::uint16_t;
+
+// Process-wide table of event source names ("telegram", "loopback", ...). Producers intern
+// their name once and stamp events with the id; 0 is the unnamed source. Returned views
+// stay valid for the lifetime of the process.
+class EventSources {
+public:
+    EventSources() = delete;
+
+    [[nodiscard]] static auto intern(std::string_view name) -> SourceId;
+    [[nodiscard]] static auto name(SourceId id) -> std::string_view;
+};
+
+}  // namespace engine::events
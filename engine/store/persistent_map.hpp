@@ -0,0 +1,250 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace engine::store {
+
+// Immutable ordered map: an AVL tree whose updates copy only the nodes on the path to the
+// changed key, so copies are O(1) and set / erase are O(log n) while every untouched
+// subtree stays shared with the previous version.
+template <typename Key, typename Value, typename Compare = std::less<Key>>
+class PersistentMap {
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+
+    struct Node {
+        std::pair<const Key, Value> entry;
+        NodePtr left{};
+        NodePtr right{};
+        std::uint8_t height{1};
+        std::size_t size{1};
+    };
+
+public:
+    using value_type = std::pair<const Key, Value>;
+
+    // in key order; holds raw node pointers, so it is only valid while a map sharing the
+    // nodes is alive
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = PersistentMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        const_iterator() = default;
+
+        auto operator*() const -> const value_type& { return path_.back()->entry; }
+        auto operator->() const -> const value_type* { return &path_.back()->entry; }
+
+        auto operator++() -> const_iterator& {
+            const Node* node = path_.back();
+            path_.pop_back();
+            descend_left(node->right.get());
+            return *this;
+        }
+        auto operator++(int) -> const_iterator {
+            auto previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        friend auto operator==(const const_iterator& lhs, const const_iterator& rhs) -> bool {
+            const Node* left = lhs.path_.empty() ? nullptr : lhs.path_.back();
+            const Node* right = rhs.path_.empty() ? nullptr : rhs.path_.back();
+            return left == right;
+        }
+
+    private:
+        friend class PersistentMap;
+
+        // the stack holds every ancestor still to be visited, the current node on top
+        void descend_left(const Node* node) {
+            for (; node != nullptr; node = node->left.get()) {
+                path_.push_back(node);
+            }
+        }
+
+        std::vector<const Node*> path_{};
+    };
+
+    PersistentMap() = default;
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t { return size_of(root_.get()); }
+    [[nodiscard]] auto empty() const noexcept -> bool { return root_ == nullptr; }
+    // true when both share the same tree, i.e. one is an unmodified copy of the other; O(1)
+    [[nodiscard]] auto same_as(const PersistentMap& other) const noexcept -> bool { return root_ == other.root_; }
+
+    [[nodiscard]] auto begin() const -> const_iterator {
+        const_iterator it{};
+        it.descend_left(root_.get());
+        return it;
+    }
+    [[nodiscard]] auto end() const -> const_iterator { return const_iterator{}; }
+
+    // first entry whose key is not less than `key`
+    [[nodiscard]] auto lower_bound(const Key& key) const -> const_iterator {
+        const_iterator it{};
+        for (const Node* node = root_.get(); node != nullptr;) {
+            if (Compare{}(node->entry.first, key)) {
+                node = node->right.get();
+            } else {
+                it.path_.push_back(node);
+                node = node->left.get();
+            }
+        }
+        return it;
+    }
+
+    // number of entries whose key is less than `key`
+    [[nodiscard]] auto rank(const Key& key) const -> std::size_t {
+        std::size_t before = 0;
+        for (const Node* node = root_.get(); node != nullptr;) {
+            if (Compare{}(node->entry.first, key)) {
+                before += size_of(node->left.get()) + 1;
+                node = node->right.get();
+            } else {
+                node = node->left.get();
+            }
+        }
+        return before;
+    }
+
+    // the entry at position `index` in key order, or end()
+    [[nodiscard]] auto at_rank(std::size_t index) const -> const_iterator {
+        const_iterator it{};
+        if (index >= size()) {
+            return it;
+        }
+        for (const Node* node = root_.get(); node != nullptr;) {
+            const auto left_size = size_of(node->left.get());
+            if (index < left_size) {
+                it.path_.push_back(node);
+                node = node->left.get();
+            } else if (index == left_size) {
+                it.path_.push_back(node);
+                break;
+            } else {
+                index -= left_size + 1;
+                node = node->right.get();
+            }
+        }
+        return it;
+    }
+
+    [[nodiscard]] auto find(const Key& key) const -> const Value* {
+        for (const Node* node = root_.get(); node != nullptr;) {
+            if (Compare{}(key, node->entry.first)) {
+                node = node->left.get();
+            } else if (Compare{}(node->entry.first, key)) {
+                node = node->right.get();
+            } else {
+                return &node->entry.second;
+            }
+        }
+        return nullptr;
+    }
+    [[nodiscard]] auto contains(const Key& key) const -> bool { return find(key) != nullptr; }
+
+    // inserts or replaces
+    [[nodiscard]] auto set(const Key& key, Value value) const -> PersistentMap {
+        PersistentMap next{};
+        next.root_ = insert(root_, key, std::move(value));
+        return next;
+    }
+
+    [[nodiscard]] auto erase(const Key& key) const -> PersistentMap {
+        if (!contains(key)) {
+            return *this;
+        }
+        PersistentMap next{};
+        next.root_ = remove(root_, key);
+        return next;
+    }
+
+private:
+    static auto height_of(const Node* node) noexcept -> int { return node != nullptr ? node->height : 0; }
+    static auto size_of(const Node* node) noexcept -> std::size_t { return node != nullptr ? node->size : 0; }
+
+    static auto make_node(const value_type& entry, NodePtr left, NodePtr right) -> NodePtr {
+        const auto height = 1 + std::max(height_of(left.get()), height_of(right.get()));
+        const auto size = 1 + size_of(left.get()) + size_of(right.get());
+        return std::make_shared<const Node>(Node{
+            .entry = entry,
+            .left = std::move(left),
+            .right = std::move(right),
+            .height = static_cast<std::uint8_t>(height),
+            .size = size
+        });
+    }
+
+    // rebuilds `entry` over two subtrees whose heights differ by at most two
+    static auto balance(const value_type& entry, NodePtr left, NodePtr right) -> NodePtr {
+        const auto lh = height_of(left.get());
+        const auto rh = height_of(right.get());
+        if (lh > rh + 1) {
+            if (height_of(left->left.get()) >= height_of(left->right.get())) {
+                return make_node(left->entry, left->left, make_node(entry, left->right, std::move(right)));
+            }
+            const auto& pivot = left->right;
+            return make_node(pivot->entry,
+                             make_node(left->entry, left->left, pivot->left),
+                             make_node(entry, pivot->right, std::move(right)));
+        }
+        if (rh > lh + 1) {
+            if (height_of(right->right.get()) >= height_of(right->left.get())) {
+                return make_node(right->entry, make_node(entry, std::move(left), right->left), right->right);
+            }
+            const auto& pivot = right->left;
+            return make_node(pivot->entry,
+                             make_node(entry, std::move(left), pivot->left),
+                             make_node(right->entry, pivot->right, right->right));
+        }
+        return make_node(entry, std::move(left), std::move(right));
+    }
+
+    static auto insert(const NodePtr& node, const Key& key, Value value) -> NodePtr {
+        if (node == nullptr) {
+            return make_node(value_type{key, std::move(value)}, nullptr, nullptr);
+        }
+        if (Compare{}(key, node->entry.first)) {
+            return balance(node->entry, insert(node->left, key, std::move(value)), node->right);
+        }
+        if (Compare{}(node->entry.first, key)) {
+            return balance(node->entry, node->left, insert(node->right, key, std::move(value)));
+        }
+        return make_node(value_type{key, std::move(value)}, node->left, node->right);
+    }
+
+    static auto remove(const NodePtr& node, const Key& key) -> NodePtr {
+        if (Compare{}(key, node->entry.first)) {
+            return balance(node->entry, remove(node->left, key), node->right);
+        }
+        if (Compare{}(node->entry.first, key)) {
+            return balance(node->entry, node->left, remove(node->right, key));
+        }
+        if (node->left == nullptr) {
+            return node->right;
+        }
+        if (node->right == nullptr) {
+            return node->left;
+        }
+        const Node* successor = node->right.get();
+        while (successor->left != nullptr) {
+            successor = successor->left.get();
+        }
+        return balance(successor->entry, node->left, remove(node->right, successor->entry.first));
+    }
+
+    NodePtr root_{};
+};
+
+}  // namespace engine::store
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace engine::store {
+
+// Immutable vector with structural sharing: a 32-way trie of leaves plus a separate tail
+// leaf (Bagwell / Clojure layout). Copies share every node, push_back and set copy one
+// path of at most log32(n) nodes, and indexing walks that path.
+template <typename T>
+class PersistentVector {
+    static constexpr std::size_t kBits = 5;
+    static constexpr std::size_t kWidth = std::size_t{1} << kBits;
+    static constexpr std::size_t kMask = kWidth - 1;
+
+    // branches only use children, leaves only use values
+    struct Node {
+        std::vector<std::shared_ptr<const Node>> children{};
+        std::vector<T> values{};
+    };
+    using NodePtr = std::shared_ptr<const Node>;
+
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() = default;
+
+        auto operator*() const -> const T& { return (*owner_)[index_]; }
+        auto operator->() const -> const T* { return &(*owner_)[index_]; }
+
+        auto operator++() -> const_iterator& {
+            ++index_;
+            return *this;
+        }
+        auto operator++(int) -> const_iterator {
+            auto previous = *this;
+            ++index_;
+            return previous;
+        }
+        auto operator--() -> const_iterator& {
+            --index_;
+            return *this;
+        }
+        auto operator--(int) -> const_iterator {
+            auto previous = *this;
+            --index_;
+            return previous;
+        }
+
+        friend auto operator==(const const_iterator& lhs, const const_iterator& rhs) -> bool {
+            return lhs.index_ == rhs.index_;
+        }
+
+    private:
+        friend class PersistentVector;
+
+        const_iterator(const PersistentVector* owner, std::size_t index)
+            : owner_{owner},
+              index_{index} {}
+
+        const PersistentVector* owner_{nullptr};
+        std::size_t index_{0};
+    };
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    PersistentVector() = default;
+
+    // builds the leaves directly instead of going through push_back
+    explicit PersistentVector(const std::vector<T>& values) {
+        std::shared_ptr<Node> tail{};
+        for (const auto& value : values) {
+            if (tail != nullptr && tail->values.size() == kWidth) {
+                tail_ = std::move(tail);
+                push_tail_into_tree();
+                tail.reset();
+            }
+            if (tail == nullptr) {
+                tail = std::make_shared<Node>();
+                tail->values.reserve(kWidth);
+            }
+            tail->values.push_back(value);
+            ++size_;
+        }
+        tail_ = std::move(tail);
+    }
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t { return size_; }
+    [[nodiscard]] auto empty() const noexcept -> bool { return size_ == 0; }
+    // true when both share every node, i.e. one is an unmodified copy of the other; O(1)
+    [[nodiscard]] auto same_as(const PersistentVector& other) const noexcept -> bool {
+        return size_ == other.size_ && root_ == other.root_ && tail_ == other.tail_;
+    }
+
+    // unchecked, like std::vector
+    auto operator[](std::size_t index) const -> const T& {
+        return leaf_for(index)->values[index & kMask];
+    }
+    [[nodiscard]] auto front() const -> const T& { return (*this)[0]; }
+    [[nodiscard]] auto back() const -> const T& { return (*this)[size_ - 1]; }
+
+    [[nodiscard]] auto begin() const -> const_iterator { return const_iterator{this, 0}; }
+    [[nodiscard]] auto end() const -> const_iterator { return const_iterator{this, size_}; }
+    [[nodiscard]] auto rbegin() const -> const_reverse_iterator { return const_reverse_iterator{end()}; }
+    [[nodiscard]] auto rend() const -> const_reverse_iterator { return const_reverse_iterator{begin()}; }
+
+    [[nodiscard]] auto push_back(T value) const -> PersistentVector {
+        PersistentVector next = *this;
+        const auto tail_size = size_ - tail_offset();
+        if (tail_size < kWidth) {
+            auto tail = std::make_shared<Node>();
+            tail->values.reserve(kWidth);
+            if (tail_ != nullptr) {
+                tail->values = tail_->values;
+            }
+            tail->values.push_back(std::move(value));
+            next.tail_ = std::move(tail);
+        } else {
+            next.push_tail_into_tree();
+            auto tail = std::make_shared<Node>();
+            tail->values.reserve(kWidth);
+            tail->values.push_back(std::move(value));
+            next.tail_ = std::move(tail);
+        }
+        ++next.size_;
+        return next;
+    }
+
+    [[nodiscard]] auto set(std::size_t index, T value) const -> PersistentVector {
+        PersistentVector next = *this;
+        if (index >= tail_offset()) {
+            auto tail = std::make_shared<Node>(*tail_);
+            tail->values[index & kMask] = std::move(value);
+            next.tail_ = std::move(tail);
+        } else {
+            next.root_ = assoc(shift_, root_, index, std::move(value));
+        }
+        return next;
+    }
+
+    [[nodiscard]] auto to_vector() const -> std::vector<T> {
+        return std::vector<T>(begin(), end());
+    }
+
+private:
+    // first index held by the tail
+    [[nodiscard]] auto tail_offset() const noexcept -> std::size_t {
+        return size_ < kWidth ? 0 : ((size_ - 1) >> kBits) << kBits;
+    }
+
+    [[nodiscard]] auto leaf_for(std::size_t index) const -> const Node* {
+        if (index >= tail_offset()) {
+            return tail_.get();
+        }
+        const Node* node = root_.get();
+        for (auto level = shift_; level > 0; level -= kBits) {
+            node = node->children[(index >> level) & kMask].get();
+        }
+        return node;
+    }
+
+    // moves a full tail into the trie; size_ already counts the tail's values
+    void push_tail_into_tree() {
+        if ((size_ >> kBits) > (std::size_t{1} << shift_)) {
+            auto root = std::make_shared<Node>();
+            root->children.push_back(root_);
+            root->children.push_back(new_path(shift_, tail_));
+            root_ = std::move(root);
+            shift_ += kBits;
+        } else {
+            root_ = push_tail(shift_, root_, tail_);
+        }
+    }
+
+    [[nodiscard]] auto push_tail(std::size_t level, const NodePtr& parent, const NodePtr& tail) const -> NodePtr {
+        auto node = parent != nullptr ? std::make_shared<Node>(*parent) : std::make_shared<Node>();
+        const auto slot = ((size_ - 1) >> level) & kMask;
+
+        NodePtr inserted{};
+        if (level == kBits) {
+            inserted = tail;
+        } else if (slot < node->children.size()) {
+            inserted = push_tail(level - kBits, node->children[slot], tail);
+        } else {
+            inserted = new_path(level - kBits, tail);
+        }
+
+        if (slot < node->children.size()) {
+            node->children[slot] = std::move(inserted);
+        } else {
+            node->children.push_back(std::move(inserted));
+        }
+        return node;
+    }
+
+    [[nodiscard]] static auto new_path(std::size_t level, const NodePtr& leaf) -> NodePtr {
+        if (level == 0) {
+            return leaf;
+        }
+        auto node = std::make_shared<Node>();
+        node->children.push_back(new_path(level - kBits, leaf));
+        return node;
+    }
+
+    [[nodiscard]] static auto assoc(std::size_t level, const NodePtr& node, std::size_t index, T value) -> NodePtr {
+        auto copy = std::make_shared<Node>(*node);
+        if (level == 0) {
+            copy->values[index & kMask] = std::move(value);
+        } else {
+            const auto slot = (index >> level) & kMask;
+            copy->children[slot] = assoc(level - kBits, node->children[slot], index, std::move(value));
+        }
+        return copy;
+    }
+
+    std::size_t size_{0};
+    std::size_t shift_{kBits};
+    NodePtr root_{};
+    NodePtr tail_{};
+};
+
+}  // namespace engine::store
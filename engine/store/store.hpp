@@ -1,21 +1,41 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
+#include <cstdint>
 #include <functional>
+#include <limits>
+#include <memory>
 #include <mutex>
+#include <span>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace engine::store {
 
+// A projection of the state plus the version of the slices it reads. `version` must change
+// whenever `project` could return something different; `project` only runs when it does.
+template <typename State, typename T>
+struct Selector {
+    std::function<std::uint64_t(const State&)> version{};
+    std::function<T(const State&)> project{};
+};
+
+// Each dispatch publishes a new immutable snapshot through an atomic shared_ptr, and the
+// subscriber list is copy-on-write the same way, so reading state never takes a lock and
+// never waits for a reducer. Dispatches are serialized by a writer mutex that readers do
+// not touch; the reducer runs while the previous snapshot stays readable.
 template <typename State, typename Action>
 class Store {
 public:
     using Reducer = std::function<State(const State&, const Action&)>;
     using Subscriber = std::function<void(const State&)>;
+    // an immutable published state; holding one keeps it alive past later dispatches
+    using Snapshot = std::shared_ptr<const State>;
 
     explicit Store(State initial_state, Reducer reducer)
-        : state_{std::move(initial_state)},
+        : state_{std::make_shared<const State>(std::move(initial_state))},
           reducer_{std::move(reducer)} {}
 
     Store(const Store&) = delete;
@@ -24,39 +44,85 @@ public:
     auto operator=(Store&&) -> Store& = delete;
     ~Store() = default;
 
+    // copies the current state; prefer snapshot() where a reference will do
     auto state() const -> State {
-        std::lock_guard lock(mutex_);
-        return state_;
+        return *snapshot();
+    }
+
+    // any thread
+    [[nodiscard]] auto snapshot() const -> Snapshot {
+        return state_.load(std::memory_order_acquire);
     }
 
     auto subscribe(Subscriber subscriber) -> std::size_t {
         const auto token = next_token_.fetch_add(1);
-        std::lock_guard lock(mutex_);
-        subscribers_.push_back({token, std::move(subscriber)});
+        std::lock_guard lock(subscribers_mutex_);
+        auto next = std::make_shared<std::vector<SubscriberEntry>>(*subscribers_.load());
+        next->push_back({token, std::move(subscriber)});
+        subscribers_.store(std::move(next));
         return token;
     }
 
-    void unsubscribe(std::size_t token) {
-        std::lock_guard lock(mutex_);
-        subscribers_.erase(
-            std::remove_if(
-                subscribers_.begin(),
-                subscribers_.end(),
-                [token](const SubscriberEntry& entry) { return entry.token == token; }
-            ),
-            subscribers_.end()
+    // `handler` runs with the new projection after dispatches that changed the selector's
+    // version, and not for the state current at subscription; unsubscribe with the token
+    template <typename T>
+    auto subscribe(Selector<State, T> selector, std::type_identity_t<std::function<void(const T&)>> handler)
+        -> std::size_t {
+        constexpr auto kUnseen = std::numeric_limits<std::uint64_t>::max();
+        auto seen = std::make_shared<std::atomic<std::uint64_t>>(kUnseen);
+
+        const auto token = subscribe(
+            [selector, handler = std::move(handler), seen](const State& snapshot) {
+                const auto version = selector.version(snapshot);
+                if (seen->exchange(version) == version) {
+                    return;
+                }
+                handler(selector.project(snapshot));
+            }
         );
+        // taken after registering so a dispatch racing the subscription is not missed
+        auto expected = kUnseen;
+        seen->compare_exchange_strong(expected, selector.version(*snapshot()));
+        return token;
+    }
+
+    void unsubscribe(std::size_t token) {
+        std::lock_guard lock(subscribers_mutex_);
+        auto next = std::make_shared<std::vector<SubscriberEntry>>(*subscribers_.load());
+        std::erase_if(*next, [token](const SubscriberEntry& entry) { return entry.token == token; });
+        subscribers_.store(std::move(next));
     }
 
     void dispatch(const Action& action) {
-        State next;
+        Snapshot next{};
         {
-            std::lock_guard lock(mutex_);
-            next = reducer_(state_, action);
-            state_ = next;
+            std::lock_guard lock(dispatch_mutex_);
+            next = std::make_shared<const State>(reducer_(*state_.load(std::memory_order_relaxed), action));
+            state_.store(next, std::memory_order_release);
         }
 
-        notify(next);
+        notify(*next);
+    }
+
+    // folds every action into one new state and notifies once; subscribers and readers
+    // never see the intermediate states
+    void dispatch_batch(std::span<const Action> actions) {
+        if (actions.empty()) {
+            return;
+        }
+
+        Snapshot next{};
+        {
+            std::lock_guard lock(dispatch_mutex_);
+            State folded = *state_.load(std::memory_order_relaxed);
+            for (const auto& action : actions) {
+                folded = reducer_(folded, action);
+            }
+            next = std::make_shared<const State>(std::move(folded));
+            state_.store(next, std::memory_order_release);
+        }
+
+        notify(*next);
     }
 
 private:
@@ -65,26 +131,24 @@ private:
         Subscriber subscriber{};
     };
 
-    void notify(const State& snapshot) {
-        std::vector<SubscriberEntry> subs_copy;
-        {
-            std::lock_guard lock(mutex_);
-            subs_copy = subscribers_;
-        }
-        for (const auto& entry : subs_copy) {
+    // subscribers added or removed meanwhile take effect from the next dispatch
+    void notify(const State& snapshot) const {
+        const auto subscribers = subscribers_.load();
+        for (const auto& entry : *subscribers) {
             if (entry.subscriber) {
                 entry.subscriber(snapshot);
             }
         }
     }
 
-    mutable std::mutex mutex_{};
-    State state_{};
+    std::atomic<Snapshot> state_;
     Reducer reducer_{};
-    std::vector<SubscriberEntry> subscribers_{};
+    std::mutex dispatch_mutex_{};
+    std::mutex subscribers_mutex_{};
+    std::atomic<std::shared_ptr<const std::vector<SubscriberEntry>>> subscribers_{
+        std::make_shared<const std::vector<SubscriberEntry>>()
+    };
     std::atomic<std::size_t> next_token_{1};
 };
 
 }  // namespace engine::store
-
-
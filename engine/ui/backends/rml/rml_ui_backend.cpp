@@ -3,7 +3,10 @@
 #include <SDL.h>
 #include <RmlUi/Core/Input.h>
 
+#include <algorithm>
+#include <iostream>
 #include <memory>
+#include <unordered_set>
 
 #include "engine/platform/sdl_platform.hpp"
 #include "engine/render/renderer.hpp"
@@ -71,6 +74,9 @@ void RmlUiBackend::initialize() {
 
 void RmlUiBackend::shutdown() {
     destroy_documents();
+    // the context owns the models and removes them with it
+    data_models_.clear();
+    retired_data_models_.clear();
 
     if (context_ != nullptr) {
         Rml::RemoveContext(context_->GetName());
@@ -83,6 +89,12 @@ void RmlUiBackend::shutdown() {
 void RmlUiBackend::update(float) {
     if (context_ != nullptr) {
         context_->Update();
+        for (const auto& name : retired_data_models_) {
+            if (!data_models_.contains(name)) {
+                context_->RemoveDataModel(name);
+            }
+        }
+        retired_data_models_.clear();
     }
 }
 
@@ -130,27 +142,81 @@ void RmlUiBackend::process_event(const SDL_Event& event) {
     }
 }
 
+// Documents are matched to the loaded ones by screen key. A document whose revision is
+// already loaded stays as it is, listeners included; only rebuilt or new documents are
+// parsed, and only documents that end up above a newly loaded one are restacked.
 void RmlUiBackend::sync_documents(const std::vector<UiDocument>& documents) {
     if (context_ == nullptr) {
         return;
     }
 
-    destroy_documents();
+    std::vector<DocumentRecord> previous = std::move(documents_);
+    documents_.clear();
     documents_.reserve(documents.size());
 
+    const auto find_previous = [&previous](std::uint64_t screen_key) {
+        return std::find_if(previous.begin(), previous.end(), [screen_key](const DocumentRecord& record) {
+            return record.document != nullptr && record.screen_key == screen_key;
+        });
+    };
+
+    // documents leaving the stack or rebuilt close before models are retired
+    for (auto& record : previous) {
+        const auto wanted = std::any_of(documents.begin(), documents.end(), [&record](const UiDocument& doc) {
+            return doc.screen_key == record.screen_key && doc.revision == record.revision;
+        });
+        if (!wanted) {
+            close_document(record);
+        }
+    }
+    bind_data_models(documents);
+
+    // hidden documents are only shown or hidden; stacking order is kept among visible ones
+    bool restack = false;
+    std::ptrdiff_t last_kept = -1;
     for (const auto& doc : documents) {
-        DocumentRecord record{};
-        record.document = context_->LoadDocumentFromMemory(doc.markup);
-        if (record.document == nullptr) {
+        const auto kept = find_previous(doc.screen_key);
+        if (kept != previous.end()) {
+            if (doc.visible) {
+                const auto position = kept - previous.begin();
+                const bool shown = !kept->visible;
+                restack = restack || shown || position < last_kept;
+                last_kept = position;
+                if (shown) {
+                    kept->document->Show();
+                }
+                if (restack) {
+                    kept->document->PullToFront();
+                }
+            } else if (kept->visible) {
+                kept->document->Hide();
+            }
+            kept->visible = doc.visible;
+            documents_.push_back(std::move(*kept));
+            kept->document = nullptr;
             continue;
         }
 
-        record.document->Show();
-        attach_listeners(*record.document, doc, record.listeners);
+        auto record = load_document(doc);
+        if (record.document == nullptr) {
+            continue;
+        }
+        restack = restack || doc.visible;
         documents_.push_back(std::move(record));
     }
 }
 
+void RmlUiBackend::refresh_data_model(const UiDataModel& model, std::span<const std::string> variables) {
+    const auto it = data_models_.find(model.name());
+    if (it == data_models_.end() || it->second.source != &model) {
+        return;
+    }
+
+    for (const auto& variable : variables) {
+        it->second.handle.DirtyVariable(variable);
+    }
+}
+
 void RmlUiBackend::load_font(std::string_view path) {
     const auto resolved = resources_.resolve(path);
     Rml::LoadFontFace(resolved.string().c_str());
@@ -158,15 +224,102 @@ void RmlUiBackend::load_font(std::string_view path) {
 
 void RmlUiBackend::destroy_documents() {
     for (auto& record : documents_) {
-        detach_listeners(record.listeners);
-        if (record.document != nullptr) {
-            record.document->Close();
-            record.document = nullptr;
-        }
+        close_document(record);
     }
     documents_.clear();
 }
 
+void RmlUiBackend::close_document(DocumentRecord& record) {
+    detach_listeners(record.listeners);
+    if (record.document != nullptr) {
+        record.document->Close();
+        record.document = nullptr;
+    }
+}
+
+auto RmlUiBackend::load_document(const UiDocument& definition) -> DocumentRecord {
+    DocumentRecord record{};
+    record.screen_key = definition.screen_key;
+    record.revision = definition.revision;
+    record.visible = definition.visible;
+    record.document = context_->LoadDocumentFromMemory(definition.markup);
+    if (record.document == nullptr) {
+        return record;
+    }
+
+    if (record.visible) {
+        record.document->Show();
+    }
+    attach_listeners(*record.document, definition, record.listeners);
+    return record;
+}
+
+// models outlive document reloads; a model no document references any more is retired, and
+// one whose screen was replaced by another with the same name is rebound
+void RmlUiBackend::bind_data_models(const std::vector<UiDocument>& documents) {
+    std::unordered_set<const UiDataModel*> wanted{};
+    for (const auto& doc : documents) {
+        if (doc.data_model != nullptr) {
+            wanted.insert(doc.data_model);
+        }
+    }
+
+    for (auto it = data_models_.begin(); it != data_models_.end();) {
+        if (!wanted.contains(it->second.source)) {
+            retired_data_models_.push_back(it->first);
+            it = data_models_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (const auto& doc : documents) {
+        if (doc.data_model != nullptr && !data_models_.contains(doc.data_model->name())) {
+            if (!bind_data_model(*doc.data_model)) {
+                std::cerr << "Failed to bind data model: " << doc.data_model->name() << std::endl;
+            }
+        }
+    }
+}
+
+auto RmlUiBackend::bind_data_model(UiDataModel& model) -> bool {
+    const auto retired = std::find(retired_data_models_.begin(), retired_data_models_.end(), model.name());
+    if (retired != retired_data_models_.end()) {
+        context_->RemoveDataModel(model.name());
+        retired_data_models_.erase(retired);
+    }
+
+    auto constructor = context_->CreateDataModel(model.name());
+    if (!constructor) {
+        return false;
+    }
+
+    constructor.RegisterArray<std::vector<Rml::String>>();
+    for (auto& [name, value] : model.strings()) {
+        constructor.Bind(name, &value);
+    }
+    for (auto& [name, values] : model.lists()) {
+        constructor.Bind(name, &values);
+    }
+    for (const auto& [name, handler] : model.events()) {
+        constructor.BindEventCallback(
+            name,
+            [&model, event = name](Rml::DataModelHandle, Rml::Event&, const Rml::VariantList& arguments) {
+                const auto index = arguments.empty() ? 0 : arguments.front().Get<int>();
+                if (index >= 0) {
+                    model.invoke(event, static_cast<std::size_t>(index));
+                }
+            }
+        );
+    }
+
+    data_models_.insert_or_assign(model.name(), DataModelRecord{
+        .source = &model,
+        .handle = constructor.GetModelHandle()
+    });
+    return true;
+}
+
 void RmlUiBackend::attach_listeners(Rml::ElementDocument& document,
                                     const UiDocument& definition,
                                     std::vector<ListenerBinding>& out_listeners) {
@@ -2,7 +2,10 @@
 
 #include <RmlUi/Core.h>
 
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -45,6 +48,7 @@ public:
     void render() override;
     void process_event(const SDL_Event& event) override;
     void sync_documents(const std::vector<UiDocument>& documents) override;
+    void refresh_data_model(const UiDataModel& model, std::span<const std::string> variables) override;
     void load_font(std::string_view path) override;
 
 private:
@@ -55,11 +59,23 @@ private:
         std::unique_ptr<ListenerHolder> listener{};
     };
     struct DocumentRecord {
+        std::uint64_t screen_key{0};
+        std::uint64_t revision{0};
+        bool visible{true};
         Rml::ElementDocument* document{nullptr};
         std::vector<ListenerBinding> listeners{};
     };
 
+    struct DataModelRecord {
+        const UiDataModel* source{nullptr};
+        Rml::DataModelHandle handle{};
+    };
+
     void destroy_documents();
+    void close_document(DocumentRecord& record);
+    auto load_document(const UiDocument& definition) -> DocumentRecord;
+    void bind_data_models(const std::vector<UiDocument>& documents);
+    auto bind_data_model(UiDataModel& model) -> bool;
     void attach_listeners(Rml::ElementDocument& document,
                           const UiDocument& definition,
                           std::vector<ListenerBinding>& out_listeners);
@@ -76,6 +92,9 @@ private:
     std::unique_ptr<RmlRenderInterface> render_interface_{};
     Rml::Context* context_{nullptr};
     std::vector<DocumentRecord> documents_{};
+    std::map<std::string, DataModelRecord, std::less<>> data_models_{};
+    // removed after the next context update, once the closed documents using them are gone
+    std::vector<std::string> retired_data_models_{};
 };
 
 }  // namespace engine::ui::backends::rml
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <SDL.h>
+#include <span>
+#include <string>
 #include <string_view>
 #include <vector>
 
+#include "engine/ui/ui_data_model.hpp"
 #include "engine/ui/ui_document.hpp"
 
 namespace engine::ui {
@@ -22,7 +25,11 @@ public:
     virtual void update(float dt) = 0;
     virtual void render() = 0;
     virtual void process_event(const SDL_Event& event) = 0;
+    // data models referenced by the documents are bound before they load and released once
+    // no document uses them
     virtual void sync_documents(const std::vector<UiDocument>& documents) = 0;
+    // refreshes the elements reading `variables`; the model must already be bound
+    virtual void refresh_data_model(const UiDataModel& model, std::span<const std::string> variables) = 0;
     virtual void load_font(std::string_view path) = 0;
 };
 
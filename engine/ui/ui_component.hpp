@@ -1,8 +1,11 @@
 #pragma once
 
+#include <typeindex>
+#include <typeinfo>
 #include <utility>
 
 #include "engine/ui/ui_element.hpp"
+#include "engine/ui/ui_memo_cache.hpp"
 
 namespace engine::ui {
 
@@ -23,6 +26,12 @@ class Component : public UiComponent {
 public:
     explicit Component<Props>(Props props) : props_{std::move(props)} {}
 
+    // render() unless `cache` already holds this component type with equal props; needs a
+    // `props_key(const Props&) -> PropsKey` that argument-dependent lookup finds next to Props
+    auto render_memo(UiMemoCache& cache) -> UiElement {
+        return cache.element(std::type_index{typeid(*this)}, props_key(props_), [this] { return render(); });
+    }
+
 protected:
     [[nodiscard]] auto props() const noexcept -> const Props& {
         return props_;
@@ -1,5 +1,6 @@
 #include "engine/ui/ui_context.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <unordered_set>
 #include <utility>
@@ -10,6 +11,10 @@ namespace engine::ui {
 
 namespace {
 
+// parsed element trees, computed styles and layout cost a multiple of the markup they came
+// from; only used to weigh cached documents against each other and the budget
+constexpr std::size_t kParsedBytesPerMarkupByte = 8;
+
 auto dedupe(std::vector<std::string> values) -> std::vector<std::string> {
     std::vector<std::string> result{};
     std::unordered_set<std::string> seen{};
@@ -39,6 +44,8 @@ void UiContext::set_global_styles(std::vector<std::string> styles) {
     for (auto& screen : screen_stack_) {
         screen.dirty = true;
     }
+    // cached documents were built with the old styles
+    screen_cache_.clear();
     documents_dirty_ = true;
 }
 
@@ -72,6 +79,7 @@ void UiContext::mark_dirty(std::string_view id) {
 }
 
 void UiContext::update(float dt) {
+    bool idle = pending_commands_.empty();
     process_commands();
 
     for (auto it = screen_stack_.begin(); it != screen_stack_.end();) {
@@ -87,6 +95,7 @@ void UiContext::update(float dt) {
         }
 
         if (active.dirty) {
+            idle = false;
             if (!rebuild_screen(active)) {
                 active.screen->on_detach();
                 it = screen_stack_.erase(it);
@@ -99,10 +108,16 @@ void UiContext::update(float dt) {
         ++it;
     }
 
+    // at most one preload per frame, and only in frames that had nothing else to build
+    if (idle && !documents_dirty_) {
+        preload_expected_screen();
+    }
+
     if (documents_dirty_) {
         rebuild_documents();
         documents_dirty_ = false;
     }
+    refresh_data_models();
 
     backend_->update(dt);
 }
@@ -131,9 +146,7 @@ void UiContext::process_commands() {
         switch (command.type) {
             case ScreenCommandType::ReplaceAll:
                 for (auto& screen : screen_stack_) {
-                    if (screen.screen != nullptr) {
-                        screen.screen->on_detach();
-                    }
+                    retire_screen(std::move(screen));
                 }
                 screen_stack_.clear();
                 documents_dirty_ = true;
@@ -162,6 +175,13 @@ void UiContext::process_commands() {
 }
 
 auto UiContext::push_new_screen(std::string_view id) -> bool {
+    if (auto cached = take_cached_screen(id)) {
+        cached->screen->on_attach(*this);
+        screen_stack_.push_back(std::move(*cached));
+        documents_dirty_ = true;
+        return true;
+    }
+
     auto screen = registry_.create(id);
     if (!screen) {
         std::cerr << "UiScreen not registered: " << id << std::endl;
@@ -172,6 +192,7 @@ auto UiContext::push_new_screen(std::string_view id) -> bool {
 
     ActiveScreen entry{};
     entry.id = ScreenId{id};
+    entry.key = next_screen_key_++;
     entry.screen = std::move(screen);
     entry.dirty = true;
     screen_stack_.push_back(std::move(entry));
@@ -181,14 +202,32 @@ auto UiContext::push_new_screen(std::string_view id) -> bool {
 
 void UiContext::rebuild_documents() {
     std::vector<UiDocument> documents{};
-    documents.reserve(screen_stack_.size());
+    documents.reserve(screen_cache_.size() + screen_stack_.size());
+    for (const auto& screen : screen_cache_) {
+        documents.push_back(screen.document);
+        documents.back().visible = false;
+    }
     for (const auto& screen : screen_stack_) {
         documents.push_back(screen.document);
     }
     backend_->sync_documents(documents);
 }
 
+void UiContext::refresh_data_models() {
+    for (auto& active : screen_stack_) {
+        auto* model = active.screen->data_model();
+        if (model == nullptr) {
+            continue;
+        }
+        const auto variables = model->take_dirty();
+        if (!variables.empty()) {
+            backend_->refresh_data_model(*model, variables);
+        }
+    }
+}
+
 auto UiContext::rebuild_screen(ActiveScreen& screen) -> bool {
+    screen.screen->memo_cache().begin_build();
     auto build_result = screen.screen->build();
     std::vector<std::string> style_paths = global_styles_;
     style_paths.insert(
@@ -219,6 +258,9 @@ auto UiContext::rebuild_screen(ActiveScreen& screen) -> bool {
         style_contents,
         template_markup
     );
+    screen.document.screen_key = screen.key;
+    screen.document.revision = next_revision_++;
+    screen.document.data_model = screen.screen->data_model();
     screen.dirty = false;
     return true;
 }
@@ -228,12 +270,90 @@ void UiContext::remove_screen_by_index(std::size_t index) {
         return;
     }
 
-    auto& screen = screen_stack_[index];
-    if (screen.screen != nullptr) {
-        screen.screen->on_detach();
-    }
+    auto screen = std::move(screen_stack_[index]);
     screen_stack_.erase(screen_stack_.begin() + static_cast<std::ptrdiff_t>(index));
+    retire_screen(std::move(screen));
+    documents_dirty_ = true;
+}
+
+// detaches the screen and keeps it, document and all, when its document can be shown again
+// as is; a cached screen with the same id is replaced
+void UiContext::retire_screen(ActiveScreen screen) {
+    if (screen.screen == nullptr) {
+        return;
+    }
+    screen.screen->on_detach();
     documents_dirty_ = true;
+
+    if (!screen.screen->cacheable() || screen.dirty || screen.document.markup.empty()) {
+        return;
+    }
+    std::erase_if(screen_cache_, [&screen](const ActiveScreen& cached) { return cached.id == screen.id; });
+    screen_cache_.push_back(std::move(screen));
+    evict_cached_screens();
+}
+
+auto UiContext::take_cached_screen(std::string_view id) -> std::optional<ActiveScreen> {
+    for (auto it = screen_cache_.begin(); it != screen_cache_.end(); ++it) {
+        if (it->id == id) {
+            auto screen = std::move(*it);
+            screen_cache_.erase(it);
+            return screen;
+        }
+    }
+    return std::nullopt;
+}
+
+// builds the first screen the top of the stack expects next that is neither on the stack nor
+// cached, and caches it hidden so pushing it later only shows the document
+void UiContext::preload_expected_screen() {
+    if (screen_stack_.empty() || screen_stack_.back().screen == nullptr) {
+        return;
+    }
+
+    const auto is_loaded = [this](std::string_view id) {
+        const auto matches = [id](const ActiveScreen& screen) { return screen.id == id; };
+        return std::any_of(screen_stack_.begin(), screen_stack_.end(), matches) ||
+               std::any_of(screen_cache_.begin(), screen_cache_.end(), matches);
+    };
+
+    for (const auto id : screen_stack_.back().screen->expected_next()) {
+        if (is_loaded(id) || preload_skipped_.contains(ScreenId{id})) {
+            continue;
+        }
+
+        ActiveScreen entry{};
+        entry.id = ScreenId{id};
+        entry.key = next_screen_key_++;
+        entry.screen = registry_.create(id);
+        if (entry.screen == nullptr || !entry.screen->cacheable() || !rebuild_screen(entry) ||
+            cache_cost(entry) > kScreenCacheBudget) {
+            preload_skipped_.insert(ScreenId{id});
+            continue;
+        }
+
+        screen_cache_.push_back(std::move(entry));
+        evict_cached_screens();
+        documents_dirty_ = true;
+        return;
+    }
+}
+
+void UiContext::evict_cached_screens() {
+    std::size_t total = 0;
+    for (const auto& screen : screen_cache_) {
+        total += cache_cost(screen);
+    }
+
+    while (total > kScreenCacheBudget && !screen_cache_.empty()) {
+        total -= cache_cost(screen_cache_.front());
+        screen_cache_.erase(screen_cache_.begin());
+        documents_dirty_ = true;
+    }
+}
+
+auto UiContext::cache_cost(const ActiveScreen& screen) -> std::size_t {
+    return screen.document.markup.size() * kParsedBytesPerMarkupByte;
 }
 
 auto UiContext::load_styles(const std::vector<std::string>& specific)
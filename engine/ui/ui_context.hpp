@@ -2,8 +2,12 @@
 
 #include <SDL.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <unordered_set>
 #include <vector>
 
 #include "engine/resources/resource_manager.hpp"
@@ -16,6 +20,9 @@ namespace engine::ui {
 
 class UiContext : public UiScreenHost {
 public:
+    // estimated bytes of parsed documents kept loaded for screens off the stack
+    static constexpr std::size_t kScreenCacheBudget = std::size_t{4} * 1024 * 1024;
+
     UiContext(UiBackend& backend, engine::resources::ResourceManager& resources);
     UiContext(const UiContext&) = delete;
     auto operator=(const UiContext&) -> UiContext& = delete;
@@ -45,6 +52,7 @@ private:
 
     struct ActiveScreen {
         ScreenId id{};
+        std::uint64_t key{0};
         UiScreenPtr screen{};
         UiDocument document{};
         bool dirty{true};
@@ -54,8 +62,14 @@ private:
     void process_commands();
     auto push_new_screen(std::string_view id) -> bool;
     void rebuild_documents();
+    void refresh_data_models();
     auto rebuild_screen(ActiveScreen& screen) -> bool;
     void remove_screen_by_index(std::size_t index);
+    void retire_screen(ActiveScreen screen);
+    auto take_cached_screen(std::string_view id) -> std::optional<ActiveScreen>;
+    void preload_expected_screen();
+    void evict_cached_screens();
+    [[nodiscard]] static auto cache_cost(const ActiveScreen& screen) -> std::size_t;
     auto load_styles(const std::vector<std::string>& specific) -> std::vector<std::string_view>;
 
     UiBackend* backend_{nullptr};
@@ -63,8 +77,14 @@ private:
     UiScreenRegistry registry_{};
     std::vector<std::string> global_styles_{};
     std::vector<ActiveScreen> screen_stack_{};
+    // detached screens whose documents stay loaded but hidden, least recently used first
+    std::vector<ActiveScreen> screen_cache_{};
+    // expected screens whose factory gave nothing cacheable; not tried again
+    std::unordered_set<ScreenId> preload_skipped_{};
     std::vector<ScreenCommand> pending_commands_{};
     bool documents_dirty_{false};
+    std::uint64_t next_screen_key_{1};
+    std::uint64_t next_revision_{1};
 };
 
 }  // namespace engine::ui
@@ -0,0 +1,83 @@
+#include "engine/ui/ui_data_model.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+namespace engine::ui {
+
+UiDataModel::UiDataModel(std::string name)
+    : name_{std::move(name)} {}
+
+auto UiDataModel::name() const noexcept -> const std::string& {
+    return name_;
+}
+
+void UiDataModel::declare_string(std::string_view variable) {
+    strings_.try_emplace(std::string{variable});
+}
+
+void UiDataModel::declare_list(std::string_view variable) {
+    lists_.try_emplace(std::string{variable});
+}
+
+void UiDataModel::declare_event(std::string_view event, IndexHandler handler) {
+    events_.insert_or_assign(std::string{event}, std::move(handler));
+}
+
+void UiDataModel::set_string(std::string_view variable, std::string value) {
+    const auto it = strings_.find(variable);
+    if (it == strings_.end()) {
+        std::cerr << "UiDataModel " << name_ << ": undeclared string " << variable << std::endl;
+        return;
+    }
+    if (it->second == value) {
+        return;
+    }
+    it->second = std::move(value);
+    mark_dirty(variable);
+}
+
+void UiDataModel::set_list(std::string_view variable, std::vector<std::string> values) {
+    const auto it = lists_.find(variable);
+    if (it == lists_.end()) {
+        std::cerr << "UiDataModel " << name_ << ": undeclared list " << variable << std::endl;
+        return;
+    }
+    if (it->second == values) {
+        return;
+    }
+    it->second = std::move(values);
+    mark_dirty(variable);
+}
+
+void UiDataModel::invoke(std::string_view event, std::size_t index) const {
+    const auto it = events_.find(event);
+    if (it != events_.end() && it->second) {
+        it->second(index);
+    }
+}
+
+auto UiDataModel::strings() noexcept -> std::map<std::string, std::string, std::less<>>& {
+    return strings_;
+}
+
+auto UiDataModel::lists() noexcept -> std::map<std::string, std::vector<std::string>, std::less<>>& {
+    return lists_;
+}
+
+auto UiDataModel::events() const noexcept -> const std::map<std::string, IndexHandler, std::less<>>& {
+    return events_;
+}
+
+auto UiDataModel::take_dirty() -> std::vector<std::string> {
+    return std::exchange(dirty_, {});
+}
+
+void UiDataModel::mark_dirty(std::string_view variable) {
+    if (std::find(dirty_.begin(), dirty_.end(), variable) == dirty_.end()) {
+        dirty_.emplace_back(variable);
+    }
+}
+
+}  // namespace engine::ui
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace engine::ui {
+
+// Values a screen's markup reads through data bindings ({{name}}, data-for, data-if) instead
+// of baking them into the document. The backend binds to the storage once when the document
+// loads; after that a changed value dirties only the elements that read it, with no reload.
+//
+// Declare every variable and event before the screen's document is first built; the storage
+// never moves afterwards, so backends may hold pointers into it.
+class UiDataModel {
+public:
+    // receives the index argument of data-event-*="name(i)" inside a data-for
+    using IndexHandler = std::function<void(std::size_t index)>;
+
+    explicit UiDataModel(std::string name);
+    UiDataModel(const UiDataModel&) = delete;
+    auto operator=(const UiDataModel&) -> UiDataModel& = delete;
+    UiDataModel(UiDataModel&&) = delete;
+    auto operator=(UiDataModel&&) -> UiDataModel& = delete;
+    ~UiDataModel() = default;
+
+    // the value of the data-model attribute on the element that scopes the bindings
+    [[nodiscard]] auto name() const noexcept -> const std::string&;
+
+    void declare_string(std::string_view variable);
+    void declare_list(std::string_view variable);
+    void declare_event(std::string_view event, IndexHandler handler);
+
+    // both only mark the variable dirty when the value actually changed
+    void set_string(std::string_view variable, std::string value);
+    void set_list(std::string_view variable, std::vector<std::string> values);
+
+    void invoke(std::string_view event, std::size_t index) const;
+
+    // for backends binding the storage
+    [[nodiscard]] auto strings() noexcept -> std::map<std::string, std::string, std::less<>>&;
+    [[nodiscard]] auto lists() noexcept -> std::map<std::string, std::vector<std::string>, std::less<>>&;
+    [[nodiscard]] auto events() const noexcept -> const std::map<std::string, IndexHandler, std::less<>>&;
+
+    // variables changed since the last call
+    [[nodiscard]] auto take_dirty() -> std::vector<std::string>;
+
+private:
+    void mark_dirty(std::string_view variable);
+
+    std::string name_{};
+    std::map<std::string, std::string, std::less<>> strings_{};
+    std::map<std::string, std::vector<std::string>, std::less<>> lists_{};
+    std::map<std::string, IndexHandler, std::less<>> events_{};
+    std::vector<std::string> dirty_{};
+};
+
+}  // namespace engine::ui
@@ -2,149 +2,278 @@
 
 #include "engine/ui/ui_types.hpp"
 
-#include <algorithm>
-#include <sstream>
+#include <array>
+#include <charconv>
 #include <string>
 
 namespace engine::ui {
 
 namespace {
 
+constexpr std::string_view kDocumentOpen = "<rml><head>";
+constexpr std::string_view kHeadClose = "</head>";
+constexpr std::string_view kDocumentClose = "</rml>";
+constexpr std::string_view kBodyOpen = "<body>";
+constexpr std::string_view kBodyClose = "</body>";
+constexpr std::string_view kStyleOpen = "<style type=\"text/rcss\">\n";
+constexpr std::string_view kStyleClose = "\n</style>";
+constexpr std::string_view kIdOpen = " id=\"";
+constexpr std::string_view kClassOpen = " class=\"";
+constexpr std::string_view kAutoIdPrefix = "ui_auto_";
+
+auto escaped_size(std::string_view text) noexcept -> std::size_t {
+    std::size_t size = text.size();
+    for (const char ch : text) {
+        switch (ch) {
+            case '&':
+                size += 4;  // &amp;
+                break;
+            case '<':
+            case '>':
+                size += 3;  // &lt; &gt;
+                break;
+            case '"':
+                size += 5;  // &quot;
+                break;
+            default:
+                break;
+        }
+    }
+    return size;
+}
+
+auto decimal_digits(int value) noexcept -> std::size_t {
+    std::size_t digits = 1;
+    for (; value >= 10; value /= 10) {
+        ++digits;
+    }
+    return digits;
+}
+
+// Writes the whole document into one string. measure() walks the tree first so the buffer
+// is reserved at its final size; the writing pass then appends in place, escaping text and
+// attribute values as it goes, and never builds a string per element or per subtree.
 class DocumentBuilder {
 public:
-    DocumentBuilder() = default;
+    explicit DocumentBuilder(std::string_view auto_id_prefix = kAutoIdPrefix)
+        : auto_id_prefix_{auto_id_prefix} {}
 
     auto build(UiElement root,
                std::span<const std::string_view> stylesheets,
                std::string_view template_markup) -> UiDocument {
-        std::string body_markup = render_element(std::move(root));
-
-        std::string body_template(template_markup);
-        if (body_template.empty()) {
-            body_template = std::string{kScreenContentToken};
-        }
-
+        const std::string_view body_template = template_markup.empty() ? kScreenContentToken : template_markup;
+        std::string_view before_content = body_template;
+        std::string_view after_content{};
         const auto token_pos = body_template.find(kScreenContentToken);
-        if (token_pos != std::string::npos) {
-            body_template.replace(token_pos, kScreenContentToken.size(), body_markup);
-        } else {
-            body_template.append(body_markup);
+        if (token_pos != std::string_view::npos) {
+            before_content = body_template.substr(0, token_pos);
+            after_content = body_template.substr(token_pos + kScreenContentToken.size());
         }
 
-        if (body_template.find("<body") == std::string::npos) {
-            body_template = "<body>" + body_template + "</body>";
+        const auto body_size = measure(root);
+        const bool wrap_body = body_template.find("<body") == std::string_view::npos && !has_body_element_;
+
+        std::size_t size = kDocumentOpen.size() + kHeadClose.size() + kDocumentClose.size() +
+                           before_content.size() + body_size + after_content.size();
+        for (const auto sheet : stylesheets) {
+            if (!sheet.empty()) {
+                size += kStyleOpen.size() + sheet.size() + kStyleClose.size();
+            }
+        }
+        if (wrap_body) {
+            size += kBodyOpen.size() + kBodyClose.size();
         }
+        out_.reserve(size);
 
-        std::string style_markup;
+        out_ += kDocumentOpen;
         for (const auto sheet : stylesheets) {
             if (sheet.empty()) {
                 continue;
             }
-            style_markup += "<style type=\"text/rcss\">\n";
-            style_markup.append(sheet.data(), sheet.size());
-            style_markup += "\n</style>";
+            out_ += kStyleOpen;
+            out_ += sheet;
+            out_ += kStyleClose;
         }
-
-        std::string document;
-        document.reserve(style_markup.size() + body_template.size() + 32);
-        document += "<rml><head>";
-        document += style_markup;
-        document += "</head>";
-        document += body_template;
-        document += "</rml>";
+        out_ += kHeadClose;
+        if (wrap_body) {
+            out_ += kBodyOpen;
+        }
+        out_ += before_content;
+        write_element(root);
+        out_ += after_content;
+        if (wrap_body) {
+            out_ += kBodyClose;
+        }
+        out_ += kDocumentClose;
 
         return UiDocument{
-            .markup = std::move(document),
+            .markup = std::move(out_),
+            .events = std::move(events_)
+        };
+    }
+
+    auto build_fragment(UiElement root) -> UiFragment {
+        out_.reserve(measure(root));
+        write_element(root);
+        return UiFragment{
+            .markup = std::move(out_),
             .events = std::move(events_)
         };
     }
 
 private:
-    auto render_element(UiElement element) -> std::string {
+    // exact size write_element() will produce, with auto ids counted in the same order
+    auto measure(const UiElement& element) -> std::size_t {
         if (element.tag.empty()) {
-            return {};
+            return 0;
+        }
+        has_body_element_ = has_body_element_ || element.tag == "body";
+        if (element.fragment != nullptr) {
+            return element.fragment->markup.size();
+        }
+
+        // <tag> and </tag>
+        std::size_t size = 2 * element.tag.size() + 5;
+
+        std::size_t id_size = element.id.size();
+        if (element.id.empty() && !element.events.empty()) {
+            id_size = auto_id_prefix_.size() + decimal_digits(measured_auto_ids_++);
+        }
+        if (id_size != 0) {
+            size += kIdOpen.size() + id_size + 1;
+        }
+
+        if (!element.classes.empty()) {
+            size += kClassOpen.size() + element.classes.size();  // separators and closing quote
+            for (const auto& name : element.classes) {
+                size += name.size();
+            }
+        }
+
+        for (const auto& [key, value] : element.attributes) {
+            size += key.size() + escaped_size(value) + 4;  // space, =, two quotes
+        }
+
+        if (element.text.has_value()) {
+            size += escaped_size(*element.text);
+        }
+
+        for (const auto& child : element.children) {
+            size += measure(child);
+        }
+        return size;
+    }
+
+    void write_element(UiElement& element) {
+        if (element.tag.empty()) {
+            return;
+        }
+
+        if (element.fragment != nullptr) {
+            out_ += element.fragment->markup;
+            events_.insert(events_.end(), element.fragment->events.begin(), element.fragment->events.end());
+            return;
         }
 
         if (element.id.empty() && !element.events.empty()) {
             element.id = next_auto_id();
         }
 
-        std::ostringstream oss;
-        oss << "<" << element.tag;
+        out_ += '<';
+        out_ += element.tag;
 
         if (!element.id.empty()) {
-            oss << " id=\"" << element.id << "\"";
+            out_ += kIdOpen;
+            out_ += element.id;
+            out_ += '"';
         }
 
         if (!element.classes.empty()) {
-            oss << " class=\"";
+            out_ += kClassOpen;
             for (std::size_t i = 0; i < element.classes.size(); ++i) {
-                oss << element.classes[i];
-                if (i + 1 < element.classes.size()) {
-                    oss << " ";
+                if (i > 0) {
+                    out_ += ' ';
                 }
+                out_ += element.classes[i];
             }
-            oss << "\"";
+            out_ += '"';
         }
 
         for (const auto& [key, value] : element.attributes) {
-            oss << " " << key << "=\"" << escape(value) << "\"";
+            out_ += ' ';
+            out_ += key;
+            out_ += "=\"";
+            append_escaped(value);
+            out_ += '"';
         }
 
-        oss << ">";
+        out_ += '>';
 
         if (element.text.has_value()) {
-            oss << escape(*element.text);
+            append_escaped(*element.text);
         }
 
         for (auto& child : element.children) {
-            oss << render_element(std::move(child));
+            write_element(child);
         }
 
-        oss << "</" << element.tag << ">";
+        out_ += "</";
+        out_ += element.tag;
+        out_ += '>';
 
-        for (const auto& event : element.events) {
+        for (auto& event : element.events) {
             events_.push_back(UiEventBinding{
                 .id = element.id,
-                .type = event.type,
-                .handler = event.handler
+                .type = std::move(event.type),
+                .handler = std::move(event.handler)
             });
         }
-
-        return oss.str();
     }
 
-    static auto escape(std::string_view text) -> std::string {
-        std::string result;
-        result.reserve(text.size());
-        for (const char ch : text) {
-            switch (ch) {
+    // copies the runs between special characters in one append each
+    void append_escaped(std::string_view text) {
+        std::size_t run_start = 0;
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            std::string_view entity{};
+            switch (text[i]) {
                 case '&':
-                    result.append("&amp;");
+                    entity = "&amp;";
                     break;
                 case '<':
-                    result.append("&lt;");
+                    entity = "&lt;";
                     break;
                 case '>':
-                    result.append("&gt;");
+                    entity = "&gt;";
                     break;
                 case '"':
-                    result.append("&quot;");
+                    entity = "&quot;";
                     break;
                 default:
-                    result.push_back(ch);
-                    break;
+                    continue;
             }
+            out_.append(text.substr(run_start, i - run_start));
+            out_ += entity;
+            run_start = i + 1;
         }
-        return result;
+        out_.append(text.substr(run_start));
     }
 
     [[nodiscard]] auto next_auto_id() -> std::string {
-        return "ui_auto_" + std::to_string(auto_counter_++);
+        std::array<char, 16> digits{};
+        const auto [end, error] = std::to_chars(digits.data(), digits.data() + digits.size(), auto_counter_++);
+        std::string id{};
+        id.reserve(auto_id_prefix_.size() + static_cast<std::size_t>(end - digits.data()));
+        id += auto_id_prefix_;
+        id.append(digits.data(), end);
+        return id;
     }
 
+    std::string_view auto_id_prefix_{};
+    std::string out_{};
     std::vector<UiEventBinding> events_{};
     int auto_counter_{0};
+    int measured_auto_ids_{0};
+    bool has_body_element_{false};
 };
 
 }  // namespace
@@ -156,5 +285,9 @@ auto build_ui_document(UiElement root,
     return builder.build(std::move(root), stylesheets, template_markup);
 }
 
-}  // namespace engine::ui
+auto serialize_ui_fragment(UiElement element, std::string_view auto_id_prefix) -> UiFragment {
+    DocumentBuilder builder{auto_id_prefix};
+    return builder.build_fragment(std::move(element));
+}
 
+}  // namespace engine::ui
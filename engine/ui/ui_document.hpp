@@ -1,22 +1,36 @@
 #pragma once
 
+#include <cstdint>
 #include <span>
 #include <string>
 #include <string_view>
 #include <vector>
 
+#include "engine/ui/ui_data_model.hpp"
 #include "engine/ui/ui_element.hpp"
 
 namespace engine::ui {
 
 struct UiDocument {
+    // stable for one screen on the stack; a new revision means the markup was rebuilt, so
+    // backends can keep documents whose screen and revision they already loaded
+    std::uint64_t screen_key{0};
+    std::uint64_t revision{0};
+    // hidden documents are cached screens kept loaded for navigation
+    bool visible{true};
     std::string markup{};
     std::vector<UiEventBinding> events{};
+    // owned by the screen; null when the markup has no data bindings
+    UiDataModel* data_model{nullptr};
 };
 
 auto build_ui_document(UiElement root,
                        std::span<const std::string_view> stylesheets,
                        std::string_view template_markup) -> UiDocument;
 
+// serializes one element on its own; elements with events but no id get ids starting with
+// `auto_id_prefix`, which must not collide with other generated ids in the same document
+auto serialize_ui_fragment(UiElement element, std::string_view auto_id_prefix) -> UiFragment;
+
 }  // namespace engine::ui
 
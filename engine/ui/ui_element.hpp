@@ -1,6 +1,7 @@
 #pragma once
 
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 #include <utility>
@@ -23,6 +24,12 @@ struct UiElementEvent {
     UiEventHandler handler{};
 };
 
+// an element already serialized to RML, with the event bindings of its subtree
+struct UiFragment {
+    std::string markup{};
+    std::vector<UiEventBinding> events{};
+};
+
 struct UiElement {
     std::string tag{};
     std::string id{};
@@ -31,6 +38,9 @@ struct UiElement {
     std::optional<std::string> text{};
     std::vector<UiElementEvent> events{};
     std::vector<UiElement> children{};
+    // when set the element is written as this markup and every other field but the tag is
+    // ignored; memoized components hand these out
+    std::shared_ptr<const UiFragment> fragment{};
 };
 
 }  // namespace engine::ui
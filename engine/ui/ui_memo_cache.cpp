@@ -0,0 +1,76 @@
+#include "engine/ui/ui_memo_cache.hpp"
+
+#include <array>
+#include <charconv>
+#include <functional>
+#include <string>
+
+#include "engine/ui/ui_document.hpp"
+
+namespace engine::ui {
+
+namespace {
+
+// boost-style mixing
+template <typename T>
+void hash_combine(std::size_t& seed, const T& value) {
+    seed ^= std::hash<T>{}(value) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+}
+
+}  // namespace
+
+void UiMemoCache::begin_build() {
+    std::erase_if(entries_, [this](const auto& entry) { return entry.second.used_in != build_; });
+    ++build_;
+}
+
+auto UiMemoCache::size() const noexcept -> std::size_t {
+    return entries_.size();
+}
+
+auto UiMemoCache::hits() const noexcept -> std::uint64_t {
+    return hits_;
+}
+
+auto UiMemoCache::misses() const noexcept -> std::uint64_t {
+    return misses_;
+}
+
+auto UiMemoCache::KeyHash::operator()(const Key& key) const noexcept -> std::size_t {
+    auto seed = key.type.hash_code();
+    hash_combine(seed, key.props_hash);
+    return seed;
+}
+
+// the fragment's generated ids are derived from the key, so they stay the same across
+// builds and never meet the document's own ui_auto_ ids
+auto UiMemoCache::insert(const Key& key, const std::string& props, UiElement element) -> Entries::iterator {
+    std::array<char, 16> digits{};
+    const auto [end, error] = std::to_chars(digits.data(), digits.data() + digits.size(), KeyHash{}(key), 16);
+    std::string prefix{"ui_memo_"};
+    prefix.append(digits.data(), end);
+    prefix += '_';
+    auto fragment = std::make_shared<const UiFragment>(serialize_ui_fragment(element, prefix));
+    return entries_.insert_or_assign(key, Entry{
+        .props = props,
+        .element = std::move(element),
+        .fragment = std::move(fragment),
+        .used_in = 0
+    }).first;
+}
+
+// a second use in the same build gets the element itself, so the document builder gives it
+// fresh ids instead of repeating the fragment's
+auto UiMemoCache::use(Entry& entry) -> UiElement {
+    if (entry.used_in == build_) {
+        return entry.element;
+    }
+    entry.used_in = build_;
+
+    UiElement element{};
+    element.tag = entry.element.tag;
+    element.fragment = entry.fragment;
+    return element;
+}
+
+}  // namespace engine::ui
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+
+#include "engine/ui/ui_element.hpp"
+
+namespace engine::ui {
+
+// What a component's markup depends on, encoded so that equal keys mean equal markup.
+// Strings are length-prefixed so neighbouring fields never run together. Handlers cannot
+// be compared; add whether there is one.
+class PropsKey {
+public:
+    auto add(std::string_view text) -> PropsKey& {
+        add(static_cast<std::uint64_t>(text.size()));
+        bytes_ += text;
+        return *this;
+    }
+
+    template <typename T>
+        requires std::is_arithmetic_v<T>
+    auto add(T value) -> PropsKey& {
+        char raw[sizeof(T)];
+        std::memcpy(raw, &value, sizeof(T));
+        bytes_.append(raw, sizeof(T));
+        return *this;
+    }
+
+    [[nodiscard]] auto bytes() const noexcept -> const std::string& { return bytes_; }
+
+private:
+    std::string bytes_{};
+};
+
+// Per-screen cache of rendered components, keyed by component type and props key. A hit
+// skips render() and hands out an element carrying the markup serialized on the miss, so a
+// rebuild only renders and serializes the components whose props changed. Entries are
+// found by a hash of the key and reused only when the whole key matches.
+//
+// Event handlers are reused with the markup: a memoized component's handlers must depend
+// only on what its props key covers (capturing the screen itself is fine).
+class UiMemoCache {
+public:
+    UiMemoCache() = default;
+
+    // call before each build; entries the previous build did not use are dropped
+    void begin_build();
+
+    template <typename Render>
+    auto element(std::type_index type, const PropsKey& props, Render&& render) -> UiElement {
+        const Key key{type, std::hash<std::string>{}(props.bytes())};
+        auto it = entries_.find(key);
+        // a hash collision renders and takes the slot over
+        if (it == entries_.end() || it->second.props != props.bytes()) {
+            ++misses_;
+            it = insert(key, props.bytes(), std::forward<Render>(render)());
+        } else {
+            ++hits_;
+        }
+        return use(it->second);
+    }
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t;
+    [[nodiscard]] auto hits() const noexcept -> std::uint64_t;
+    [[nodiscard]] auto misses() const noexcept -> std::uint64_t;
+
+private:
+    struct Key {
+        std::type_index type;
+        std::size_t props_hash{0};
+
+        friend auto operator==(const Key&, const Key&) -> bool = default;
+    };
+    struct KeyHash {
+        auto operator()(const Key& key) const noexcept -> std::size_t;
+    };
+    struct Entry {
+        std::string props{};
+        UiElement element{};
+        std::shared_ptr<const UiFragment> fragment{};
+        std::uint64_t used_in{0};
+    };
+    using Entries = std::unordered_map<Key, Entry, KeyHash>;
+
+    auto insert(const Key& key, const std::string& props, UiElement element) -> Entries::iterator;
+    auto use(Entry& entry) -> UiElement;
+
+    Entries entries_{};
+    std::uint64_t build_{1};
+    std::uint64_t hits_{0};
+    std::uint64_t misses_{0};
+};
+
+}  // namespace engine::ui
@@ -5,7 +5,9 @@
 #include <string_view>
 #include <vector>
 
+#include "engine/ui/ui_data_model.hpp"
 #include "engine/ui/ui_element.hpp"
+#include "engine/ui/ui_memo_cache.hpp"
 #include "engine/ui/ui_screen_host.hpp"
 #include "engine/ui/ui_types.hpp"
 
@@ -37,6 +39,26 @@ public:
     virtual auto update(float /*dt*/) -> bool {
         return false;
     }
+    // values the document binds to; changing them refreshes the bound elements without a
+    // rebuild
+    [[nodiscard]] virtual auto data_model() noexcept -> UiDataModel* {
+        return nullptr;
+    }
+    // true when the built document stays valid while the screen is detached, so a popped
+    // screen can be kept loaded but hidden and shown again without a rebuild; build() must
+    // then also work before the first on_attach, since the screen may be preloaded
+    [[nodiscard]] virtual auto cacheable() const noexcept -> bool {
+        return false;
+    }
+    // screens likely to be pushed from this one; cacheable ones are preloaded in idle frames
+    [[nodiscard]] virtual auto expected_next() const -> std::vector<std::string_view> {
+        return {};
+    }
+
+    // components rendered with render_memo(memo_cache()) survive rebuilds of this screen
+    [[nodiscard]] auto memo_cache() noexcept -> UiMemoCache& {
+        return memo_cache_;
+    }
 
 protected:
     [[nodiscard]] auto host() const noexcept -> UiScreenHost* {
@@ -45,6 +67,7 @@ protected:
 
 private:
     UiScreenHost* host_{nullptr};
+    UiMemoCache memo_cache_{};
 };
 
 using UiScreenPtr = std::unique_ptr<UiScreen>;
@@ -1,10 +1,16 @@
+#include <chrono>
 #include <iostream>
+#include <unordered_map>
 
 #include "engine/backend/backend_event_handlers.hpp"
+#include "engine/backend/loopback/loopback_backend.hpp"
 #include "engine/backend/network_manager.hpp"
+#include "engine/backend/replay/replay_backend.hpp"
 #include "game/state/chat_store.hpp"
 #include "engine/backend/telegram/telegram_backend.hpp"
+#include "engine/cache/chat_cache.hpp"
 #include "engine/config/config.hpp"
+#include "engine/events/event_recording.hpp"
 #include "engine/events/event_service.hpp"
 #include "engine/platform/sdl_platform.hpp"
 #include "engine/render/renderer.hpp"
@@ -22,6 +28,111 @@
 
 namespace game {
 
+namespace {
+
+// backend events get this much of each frame; the rest waits for the next one
+constexpr std::chrono::microseconds kEventDispatchBudget{4000};
+
+auto make_backend(engine::events::EventService& events,
+                  const engine::config::GameSettings& settings)
+    -> std::unique_ptr<engine::backend::Backend> {
+    if (settings.backend.kind == engine::config::BackendKind::Loopback) {
+        return std::make_unique<engine::backend::loopback::LoopbackBackend>(
+            events,
+            "loopback",
+            settings.backend.loopback
+        );
+    }
+
+    if (settings.backend.kind == engine::config::BackendKind::Replay) {
+        return std::make_unique<engine::backend::replay::ReplayBackend>(
+            events,
+            "replay",
+            settings.backend.replay
+        );
+    }
+
+    return std::make_unique<engine::backend::telegram::TelegramBackend>(
+        events,
+        "telegram",
+        settings.telegram.accounts
+    );
+}
+
+auto make_event_recorder(const engine::config::BackendSettings& settings)
+    -> std::unique_ptr<engine::events::EventRecorder> {
+    if (settings.record_path.empty()) {
+        return nullptr;
+    }
+
+    auto recorder = std::make_unique<engine::events::EventRecorder>(settings.record_path);
+    const auto opened = recorder->open();
+    if (!opened.has_value()) {
+        std::cerr << "Event recording disabled: " << opened.error() << std::endl;
+        return nullptr;
+    }
+    return recorder;
+}
+
+// loopback traffic is synthetic and regenerated every run, so only real accounts are cached
+auto make_chat_cache(const engine::config::BackendSettings& settings)
+    -> std::unique_ptr<engine::cache::ChatCache> {
+    if (settings.kind != engine::config::BackendKind::Telegram) {
+        return nullptr;
+    }
+    return std::make_unique<engine::cache::ChatCache>("cache/telegram_chats.bin");
+}
+
+// seeds the store from disk so the chat list is up before TDLib has authorized
+void warm_start(engine::cache::ChatCache& chat_cache, game::state::ChatStore& chat_store) {
+    auto snapshot = chat_cache.load();
+    if (!snapshot.has_value()) {
+        std::cerr << "Chat cache unavailable: " << snapshot.error() << std::endl;
+        return;
+    }
+    if (snapshot->chats.empty()) {
+        return;
+    }
+
+    // chats come grouped by account; keep the top of each account's list
+    std::unordered_map<engine::backend::AccountId, std::size_t> per_account{};
+    std::erase_if(snapshot->chats, [&per_account](const engine::backend::ChatSummary& chat) {
+        return ++per_account[chat.account] > game::state::kVisibleChatCount;
+    });
+
+    chat_store.dispatch(game::state::LoadCachedChats{
+        std::move(snapshot->chats),
+        std::move(snapshot->history)
+    });
+}
+
+// what the history budget left in memory and how much it still owes a refetch
+void log_history_usage(const game::state::ChatState& state) {
+    if (state.history_budget.per_chat_bytes == 0 && state.history_budget.total_bytes == 0) {
+        return;
+    }
+    std::clog << "Chat histories: " << state.history_bytes << " bytes in " << state.histories.size() << " chats"
+              << std::endl;
+    for (const auto& usage : game::state::history_usage(state)) {
+        if (usage.evicted == 0) {
+            continue;
+        }
+        std::clog << "  account " << usage.chat.account << " chat " << usage.chat.chat_id << ": " << usage.messages
+                  << " messages, " << usage.bytes << " bytes, " << usage.evicted << " evicted" << std::endl;
+    }
+}
+
+// chats whose new messages were lost to a full event ring; they stay missing until the
+// chat's history is fetched again
+void log_dropped_messages(const engine::events::EventService& events) {
+    for (const auto& drops : events.dropped_messages()) {
+        std::clog << "Dropped " << drops.dropped << " new messages for account " << drops.chat.account << " chat "
+                  << drops.chat.chat_id << std::endl;
+    }
+}
+
+}  // namespace
+
 auto run_game(engine::platform::SdlPlatform& platform,
               engine::render::Renderer& renderer,
               engine::resources::ResourceManager& resources) -> void {
@@ -39,14 +150,21 @@ auto run_game(engine::platform::SdlPlatform& platform,
     game::render::SceneRenderer scene_renderer{};
     engine::ui::UiSystem ui_system{platform, renderer, resources, config.render};
     engine::events::EventService event_service{};
+    auto event_recorder = make_event_recorder(config.backend);
+    event_service.record_to(event_recorder.get());
     game::state::ChatState initial_chat_state{};
+    initial_chat_state.history_budget = game::state::HistoryBudget{
+        .per_chat_bytes = static_cast<std::size_t>(config.history.chat_budget_kb) * 1024U,
+        .total_bytes = static_cast<std::size_t>(config.history.total_budget_kb) * 1024U
+    };
     game::state::ChatStore chat_store{std::move(initial_chat_state), game::state::reduce_chat_state};
 
-    auto backend = std::make_unique<engine::backend::telegram::TelegramBackend>(
-        event_service,
-        "telegram"
-    );
-    engine::backend::NetworkManager network_manager{std::move(backend)};
+    auto chat_cache = make_chat_cache(config.backend);
+    if (chat_cache != nullptr) {
+        warm_start(*chat_cache, chat_store);
+    }
+
+    engine::backend::NetworkManager network_manager{make_backend(event_service, config)};
     const auto start_result = network_manager.start();
     if (!start_result.has_value()) {
         std::cerr << "Network manager failed: " << start_result.error() << std::endl;
@@ -55,11 +173,7 @@ auto run_game(engine::platform::SdlPlatform& platform,
 
     state.backend_connecting = true;
 
-    auto backend_subscriptions = engine::backend::register_event_handlers(
-        event_service,
-        chat_store,
-        network_manager
-    );
+    auto backend_subscriptions = engine::backend::register_event_handlers(event_service, chat_cache.get());
 
     game::ui::initialize(ui_system, state, network_manager, chat_store);
 
@@ -80,11 +194,14 @@ auto run_game(engine::platform::SdlPlatform& platform,
     while (ctx.running) {
         ctx.dt = platform.compute_delta_seconds();
 
-        event_service.dispatch();
+        event_service.dispatch(kEventDispatchBudget);
+        engine::backend::flush_event_handlers(backend_subscriptions, chat_store);
         pipeline.run(ctx);
     }
 
     network_manager.stop();
+    log_history_usage(*chat_store.snapshot());
+    log_dropped_messages(event_service);
 }
 
 }  // namespace game
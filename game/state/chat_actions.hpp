@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
@@ -7,25 +9,60 @@
 
 namespace game::state {
 
+// `sequence` is the Event::sequence the payload arrived with; 0 when it did not come
+// through the event service
 struct SetBackendStatus {
     engine::backend::BackendStatus status{};
+    std::uint64_t sequence{0};
 };
 
+// replaces one account's slice of the chat list
 struct SetChats {
+    engine::backend::AccountId account{0};
     std::vector<engine::backend::ChatSummary> chats{};
+    std::uint64_t sequence{0};
 };
 
+// never null
 struct SetChatHistory {
-    engine::backend::ChatHistory history{};
+    engine::backend::ChatHistoryPtr history{};
+    std::uint64_t sequence{0};
 };
 
 struct AppendMessage {
     engine::backend::Message message{};
 };
 
+// new messages that arrived together, in arrival order
+struct AppendMessages {
+    std::vector<engine::backend::Message> messages{};
+};
+
 struct ResetChats {};
 
-using ChatAction = std::variant<SetBackendStatus, SetChats, SetChatHistory, AppendMessage, ResetChats>;
+// warm start from the on-disk cache before the backend is ready
+struct LoadCachedChats {
+    std::vector<engine::backend::ChatSummary> chats{};
+    std::unordered_map<engine::backend::ChatKey,
+                       std::vector<engine::backend::Message>,
+                       engine::backend::ChatKeyHash> history{};
+};
+
+// shows whatever is cached for the chat while its history is fetched
+struct SelectChat {
+    engine::backend::ChatKey chat{};
+};
+
+using ChatAction = std::variant<
+    SetBackendStatus,
+    SetChats,
+    SetChatHistory,
+    AppendMessage,
+    AppendMessages,
+    ResetChats,
+    LoadCachedChats,
+    SelectChat
+>;
 
 }  // namespace game::state
 
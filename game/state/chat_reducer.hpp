@@ -1,10 +1,174 @@
 #pragma once
 
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <optional>
+#include <unordered_set>
+#include <vector>
+
 #include "game/state/chat_actions.hpp"
 #include "game/state/chat_state.hpp"
 
 namespace game::state {
 
+inline auto same_message(const engine::backend::Message& lhs, const engine::backend::Message& rhs) -> bool {
+    return lhs.id == rhs.id && lhs.chat_id == rhs.chat_id && lhs.account == rhs.account && lhs.sender == rhs.sender
+        && lhs.timestamp == rhs.timestamp && lhs.text == rhs.text;
+}
+
+// a live message replaces whatever is indexed under its id, so a message that raced a
+// history page lands once and in id order; an exact duplicate leaves the index untouched
+inline auto upsert_message(ChatHistoryState history, const engine::backend::Message& message) -> ChatHistoryState {
+    const auto* existing = history.messages.find(message.id);
+    if (existing != nullptr) {
+        if (same_message(*existing, message)) {
+            return history;
+        }
+        history.bytes -= message_footprint(*existing);
+    }
+    history.messages = history.messages.set(message.id, message);
+    history.bytes += message_footprint(message);
+    return history;
+}
+
+// cached messages only fill ids nothing live has supplied yet
+inline auto fill_messages(ChatHistoryState history, const std::vector<engine::backend::Message>& incoming)
+    -> ChatHistoryState {
+    for (const auto& message : incoming) {
+        if (!history.messages.contains(message.id)) {
+            history.messages = history.messages.set(message.id, message);
+            history.bytes += message_footprint(message);
+        }
+    }
+    return history;
+}
+
+// incoming messages older than everything `held` has and not in it yet; only those can be
+// messages the budget dropped. All of them count while nothing is held.
+inline auto recovered_count(const MessageIndex& held, const std::vector<engine::backend::Message>& incoming)
+    -> std::size_t {
+    const auto oldest = held.empty() ? std::numeric_limits<engine::backend::MessageId>::max() : held.begin()->first;
+    std::unordered_set<engine::backend::MessageId> ids{};
+    for (const auto& message : incoming) {
+        if (message.id < oldest) {
+            ids.insert(message.id);
+        }
+    }
+    return ids.size();
+}
+
+// drops the oldest messages until the chat fits in `target_bytes`
+inline void evict_oldest(ChatHistoryState& history, std::size_t target_bytes) {
+    while (history.bytes > target_bytes && !history.messages.empty()) {
+        const auto oldest = history.messages.begin();
+        history.bytes -= message_footprint(oldest->second);
+        history.messages = history.messages.erase(oldest->first);
+        ++history.evicted;
+    }
+}
+
+// eviction goes down to this share of a budget so it does not run on every new message
+inline auto low_watermark(std::size_t budget) -> std::size_t {
+    return budget / 4 * 3;
+}
+
+// only touches `histories` when the chat changed; enforces the per-chat budget
+inline void store_history(ChatState& state, const engine::backend::ChatKey& chat, ChatHistoryState history) {
+    const auto per_chat = state.history_budget.per_chat_bytes;
+    if (per_chat != 0 && history.bytes > per_chat) {
+        evict_oldest(history, low_watermark(per_chat));
+    }
+
+    const auto* current = state.histories.find(chat);
+    if (current != nullptr && current->messages.same_as(history.messages)
+        && current->last_viewed == history.last_viewed && current->evicted == history.evicted) {
+        return;
+    }
+    state.history_bytes -= current != nullptr ? current->bytes : 0;
+    state.history_bytes += history.bytes;
+    state.histories = state.histories.set(chat, std::move(history));
+}
+
+inline void erase_history(ChatState& state, const engine::backend::ChatKey& chat) {
+    if (const auto* current = state.histories.find(chat); current != nullptr) {
+        state.history_bytes -= current->bytes;
+        state.histories = state.histories.erase(chat);
+    }
+}
+
+inline void mark_viewed(ChatState& state, const engine::backend::ChatKey& chat) {
+    auto history = history_of(state, chat);
+    history.last_viewed = ++state.view_clock;
+    store_history(state, chat, std::move(history));
+}
+
+// takes old messages from the least recently viewed chats, the selected one last, until
+// the total is back under the low watermark. Emptied chats keep their entry so the
+// evicted count still sizes their refetch.
+inline void enforce_total_budget(ChatState& state) {
+    const auto total = state.history_budget.total_bytes;
+    if (total == 0 || state.history_bytes <= total) {
+        return;
+    }
+
+    const auto target = low_watermark(total);
+    while (state.history_bytes > target) {
+        std::optional<engine::backend::ChatKey> victim{};
+        std::uint64_t victim_viewed = 0;
+        for (const auto& [chat, history] : state.histories) {
+            if (chat == state.selected_chat || history.messages.empty()) {
+                continue;
+            }
+            if (!victim.has_value() || history.last_viewed < victim_viewed) {
+                victim = chat;
+                victim_viewed = history.last_viewed;
+            }
+        }
+        if (!victim.has_value()) {
+            victim = state.selected_chat;
+        }
+        if (!victim.has_value()) {
+            return;
+        }
+
+        auto history = history_of(state, *victim);
+        if (history.messages.empty()) {
+            return;
+        }
+        evict_oldest(history, history.bytes - std::min(history.bytes, state.history_bytes - target));
+        store_history(state, *victim, std::move(history));
+    }
+}
+
+// accounts that currently have entries in the chat list
+inline auto accounts_in(const ChatSlices& chats) -> std::unordered_set<engine::backend::AccountId> {
+    std::unordered_set<engine::backend::AccountId> accounts{};
+    for (const auto& [account, slice] : chats) {
+        accounts.insert(account);
+    }
+    return accounts;
+}
+
+inline auto epoch_of(const ChatState& state, engine::backend::AccountId account) -> AccountEpoch {
+    const auto it = state.account_epochs.find(account);
+    return it != state.account_epochs.end() ? it->second : AccountEpoch{};
+}
+
+// persistent slices compare by identity, the per-account tables are a handful of entries
+inline void bump_versions(const ChatState& previous, ChatState& next) {
+    if (next.backend_ready != previous.backend_ready || next.backend_connecting != previous.backend_connecting
+        || next.account_status != previous.account_status) {
+        ++next.versions.status;
+    }
+    if (!next.chats.same_as(previous.chats) || next.stale_accounts != previous.stale_accounts) {
+        ++next.versions.chats;
+    }
+    if (next.selected_chat != previous.selected_chat || !next.histories.same_as(previous.histories)) {
+        ++next.versions.history;
+    }
+}
+
 inline auto reduce_chat_state(const ChatState& state, const ChatAction& action) -> ChatState {
     ChatState next = state;
 
@@ -12,36 +176,126 @@ inline auto reduce_chat_state(const ChatState& state, const ChatAction& action)
         [&](auto&& act) {
             using T = std::decay_t<decltype(act)>;
             if constexpr (std::is_same_v<T, SetBackendStatus>) {
-                next.backend_connecting = act.status.kind == engine::backend::BackendStatusKind::Connecting;
-                next.backend_ready = act.status.kind == engine::backend::BackendStatusKind::Ready;
-                if (act.status.kind != engine::backend::BackendStatusKind::Ready) {
-                    next.chats.clear();
-                    next.chat_history.clear();
-                    next.selected_chat.reset();
+                using engine::backend::BackendStatusKind;
+                const auto account = act.status.account;
+                const auto kind = act.status.kind;
+                next.account_status[account] = kind;
+                auto& epoch = next.account_epochs[account];
+
+                if (kind == BackendStatusKind::Connecting) {
+                    epoch.connecting = std::max(epoch.connecting, act.sequence);
+                    // keep showing what we have until the live list replaces it
+                    if (next.chats.contains(account)) {
+                        next.stale_accounts.insert(account);
+                    }
+                } else if (kind != BackendStatusKind::Ready) {
+                    epoch.cleared = std::max(epoch.cleared, act.sequence);
+                    next.chats = next.chats.erase(account);
+                    next.stale_accounts.erase(account);
+                    if (next.selected_chat.has_value() && next.selected_chat->account == account) {
+                        next.selected_chat.reset();
+                    }
+                    for (const auto& [key, history] : state.histories) {
+                        if (key.account == account) {
+                            erase_history(next, key);
+                        }
+                    }
                 }
+
+                const auto any_status = [&next](BackendStatusKind wanted) {
+                    return std::any_of(next.account_status.begin(), next.account_status.end(), [wanted](const auto& entry) {
+                        return entry.second == wanted;
+                    });
+                };
+                next.backend_connecting = any_status(BackendStatusKind::Connecting);
+                next.backend_ready = any_status(BackendStatusKind::Ready);
             } else if constexpr (std::is_same_v<T, SetChats>) {
-                next.chats = act.chats;
+                const auto epoch = epoch_of(next, act.account);
+                if (act.sequence < epoch.cleared) {
+                    return;
+                }
+                next.chats = act.chats.empty()
+                    ? next.chats.erase(act.account)
+                    : next.chats.set(act.account, engine::store::PersistentVector{act.chats});
+                // a list from before the reconnect is not the live refresh the account awaits
+                if (act.sequence < epoch.connecting && next.chats.contains(act.account)) {
+                    next.stale_accounts.insert(act.account);
+                } else {
+                    next.stale_accounts.erase(act.account);
+                }
             } else if constexpr (std::is_same_v<T, SetChatHistory>) {
-                next.selected_chat = act.history.chat_id;
-                next.chat_history = act.history.messages;
+                // pages and streamed chunks may overlap each other and live messages
+                const auto& history = *act.history;
+                if (act.sequence < epoch_of(next, history.account).cleared) {
+                    return;
+                }
+                const engine::backend::ChatKey key{history.account, history.chat_id};
+                auto merged = history_of(next, key);
+                merged.evicted -= std::min(merged.evicted, recovered_count(merged.messages, history.messages));
+                // an older range that came back finished and empty has nothing left below it
+                if (history.before != 0 && history.complete && history.messages.empty()) {
+                    merged.evicted = 0;
+                }
+                for (const auto& message : history.messages) {
+                    merged = upsert_message(std::move(merged), message);
+                }
+                store_history(next, key, std::move(merged));
+                // filling in an older range leaves the selection alone
+                if (!history.append && history.before == 0) {
+                    next.selected_chat = key;
+                    mark_viewed(next, key);
+                }
             } else if constexpr (std::is_same_v<T, AppendMessage>) {
-                if (next.selected_chat == act.message.chat_id) {
-                    next.chat_history.push_back(act.message);
+                const engine::backend::ChatKey key{act.message.account, act.message.chat_id};
+                store_history(next, key, upsert_message(history_of(next, key), act.message));
+            } else if constexpr (std::is_same_v<T, AppendMessages>) {
+                // runs of the same chat touch the outer map once
+                auto it = act.messages.begin();
+                while (it != act.messages.end()) {
+                    const engine::backend::ChatKey key{it->account, it->chat_id};
+                    auto history = history_of(next, key);
+                    for (; it != act.messages.end() && it->account == key.account && it->chat_id == key.chat_id; ++it) {
+                        history = upsert_message(std::move(history), *it);
+                    }
+                    store_history(next, key, std::move(history));
                 }
             } else if constexpr (std::is_same_v<T, ResetChats>) {
-                next.chats.clear();
-                next.chat_history.clear();
+                // the list and the histories survive as a stale view so a warm start is not
+                // thrown away
+                next.stale_accounts = accounts_in(next.chats);
                 next.selected_chat.reset();
+                next.account_status.clear();
                 next.backend_connecting = false;
                 next.backend_ready = false;
+            } else if constexpr (std::is_same_v<T, LoadCachedChats>) {
+                // cached slices only fill accounts that have nothing live yet
+                std::map<engine::backend::AccountId, std::vector<engine::backend::ChatSummary>> cached_slices{};
+                for (const auto& chat : act.chats) {
+                    cached_slices[chat.account].push_back(chat);
+                }
+                for (const auto& [account, slice] : cached_slices) {
+                    const bool has_live = next.chats.contains(account) && !next.stale_accounts.contains(account);
+                    if (has_live) {
+                        continue;
+                    }
+                    next.chats = next.chats.set(account, engine::store::PersistentVector{slice});
+                    next.stale_accounts.insert(account);
+                }
+                for (const auto& [key, messages] : act.history) {
+                    store_history(next, key, fill_messages(history_of(next, key), messages));
+                }
+            } else if constexpr (std::is_same_v<T, SelectChat>) {
+                // whatever is indexed for the chat shows while its history is fetched
+                next.selected_chat = act.chat;
+                mark_viewed(next, act.chat);
             }
         },
         action
     );
 
+    enforce_total_budget(next);
+    bump_versions(state, next);
     return next;
 }
 
 }  // namespace game::state
-
-
@@ -1,20 +1,183 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <optional>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "engine/backend/backend_types.hpp"
+#include "engine/store/persistent_map.hpp"
+#include "engine/store/persistent_vector.hpp"
 
 namespace game::state {
 
+// the chat list screen only shows the top of each account's list
+inline constexpr std::size_t kVisibleChatCount = 5;
+// newest messages requested when a chat is opened
+inline constexpr std::size_t kHistoryPageSize = 10;
+inline constexpr std::size_t kMaxHistoryRefetch = 100;
+
+// one chat's messages ordered by id; persistent, so state copies share every message and
+// a merge copies O(log n) nodes per message
+using MessageIndex = engine::store::PersistentMap<engine::backend::MessageId, engine::backend::Message>;
+// one slice per account in account order, each slice in list order; accounts without
+// chats have no entry
+using ChatSlices = engine::store::PersistentMap<engine::backend::AccountId,
+                                                engine::store::PersistentVector<engine::backend::ChatSummary>>;
+
+// what the reducer lets the message indexes grow to, in estimated bytes (see
+// message_footprint); 0 means unbounded
+struct HistoryBudget {
+    std::size_t per_chat_bytes{0};
+    std::size_t total_bytes{0};
+};
+
+// one chat's indexed messages plus the bookkeeping its budget needs
+struct ChatHistoryState {
+    MessageIndex messages{};
+    std::size_t bytes{0};
+    // older messages dropped to stay within budget and not fetched back since
+    std::size_t evicted{0};
+    // ChatState::view_clock when the chat was last opened; 0 if it never was
+    std::uint64_t last_viewed{0};
+};
+
+// bumped by the reducer whenever the matching slice of ChatState changes, so selectors
+// detect changes by comparing counters instead of the slices
+struct ChatStateVersions {
+    std::uint64_t status{0};   // backend_ready, backend_connecting, account_status
+    std::uint64_t chats{0};    // chats, stale_accounts
+    std::uint64_t history{0};  // selected_chat, histories, history_bytes
+};
+
+// Event::sequence of the statuses that last changed what an account's lists and histories
+// mean; statuses are handled ahead of lists and histories emitted before them
+struct AccountEpoch {
+    std::uint64_t cleared{0};     // latest Error or Stopped: older payloads are dropped
+    std::uint64_t connecting{0};  // latest Connecting: older lists stay stale
+};
+
+// copying a ChatState only copies the small per-account tables; chats and histories are
+// shared with the previous state
 struct ChatState {
+    // aggregated over accounts: ready once any account is, connecting while any is
     bool backend_ready{false};
     bool backend_connecting{false};
-    std::optional<engine::backend::ChatId> selected_chat{};
-    std::vector<engine::backend::ChatSummary> chats{};
-    std::vector<engine::backend::Message> chat_history{};
+    std::unordered_map<engine::backend::AccountId, engine::backend::BackendStatusKind> account_status{};
+    std::unordered_map<engine::backend::AccountId, AccountEpoch> account_epochs{};
+    // accounts whose chats came from the on-disk cache or a previous connection and
+    // await a live refresh
+    std::unordered_set<engine::backend::AccountId> stale_accounts{};
+    std::optional<engine::backend::ChatKey> selected_chat{};
+    ChatSlices chats{};
+    // every chat seen this session, live and cached messages merged by id; the least
+    // recently viewed chats lose their oldest messages first once the budget is exceeded
+    engine::store::PersistentMap<engine::backend::ChatKey, ChatHistoryState> histories{};
+    std::size_t history_bytes{0};
+    std::uint64_t view_clock{0};
+    HistoryBudget history_budget{};
+    ChatStateVersions versions{};
 };
 
-}  // namespace game::state
+inline auto chat_count(const ChatSlices& chats) -> std::size_t {
+    std::size_t count = 0;
+    for (const auto& [account, slice] : chats) {
+        count += slice.size();
+    }
+    return count;
+}
+
+inline auto history_of(const ChatState& state, const engine::backend::ChatKey& chat) -> ChatHistoryState {
+    const auto* history = state.histories.find(chat);
+    return history != nullptr ? *history : ChatHistoryState{};
+}
 
+// empty while nothing is selected
+inline auto selected_history(const ChatState& state) -> MessageIndex {
+    return state.selected_chat.has_value() ? history_of(state, *state.selected_chat).messages : MessageIndex{};
+}
 
+// rough heap cost of one indexed message: the tree node holding it plus its text. Text
+// chunks are shared between messages, so this overstates arena-backed text a little.
+inline auto message_footprint(const engine::backend::Message& message) -> std::size_t {
+    constexpr std::size_t kNodeOverhead = 64;
+    return sizeof(engine::backend::Message) + kNodeOverhead + message.text.size();
+}
+
+struct ChatHistoryUsage {
+    engine::backend::ChatKey chat{};
+    std::size_t messages{0};
+    std::size_t bytes{0};
+    std::size_t evicted{0};
+};
+
+// per chat, in key order
+inline auto history_usage(const ChatState& state) -> std::vector<ChatHistoryUsage> {
+    std::vector<ChatHistoryUsage> usage{};
+    usage.reserve(state.histories.size());
+    for (const auto& [chat, history] : state.histories) {
+        usage.push_back(ChatHistoryUsage{chat, history.messages.size(), history.bytes, history.evicted});
+    }
+    return usage;
+}
+
+// a fetch of messages the budget dropped: the ones just below `before`, the oldest id the
+// chat still holds
+struct EvictedRange {
+    engine::backend::MessageId before{0};
+    std::int32_t limit{0};
+};
+
+// the evicted range a read of `limit` messages below `before` runs into, if the read needs
+// more than the chat still holds and the budget dropped older messages from it. An emptied
+// chat has no boundary to fetch from; its newest page brings the messages back.
+inline auto evicted_range(const ChatState& state,
+                          const engine::backend::ChatKey& chat,
+                          engine::backend::MessageId before,
+                          std::size_t limit) -> std::optional<EvictedRange> {
+    const auto* history = state.histories.find(chat);
+    if (history == nullptr || history->evicted == 0 || history->messages.empty()) {
+        return std::nullopt;
+    }
+    const auto held = history->messages.rank(before);
+    if (held >= limit) {
+        return std::nullopt;
+    }
+    const auto wanted = std::max(limit - held, kHistoryPageSize);
+    return EvictedRange{
+        .before = history->messages.begin()->first,
+        .limit = static_cast<std::int32_t>(std::min({wanted, history->evicted, kMaxHistoryRefetch}))
+    };
+}
+
+// up to `limit` messages with ids below `before`, oldest first
+inline auto messages_before(const MessageIndex& history, engine::backend::MessageId before, std::size_t limit)
+    -> std::vector<engine::backend::Message> {
+    const auto end = history.rank(before);
+    const auto begin = end - std::min(end, limit);
+
+    std::vector<engine::backend::Message> messages{};
+    messages.reserve(end - begin);
+    auto it = history.at_rank(begin);
+    for (auto i = begin; i < end; ++i, ++it) {
+        messages.push_back(it->second);
+    }
+    return messages;
+}
+
+// up to `limit` of the newest messages, oldest first
+inline auto latest_messages(const MessageIndex& history, std::size_t limit) -> std::vector<engine::backend::Message> {
+    const auto begin = history.size() - std::min(history.size(), limit);
+
+    std::vector<engine::backend::Message> messages{};
+    messages.reserve(history.size() - begin);
+    for (auto it = history.at_rank(begin); it != history.end(); ++it) {
+        messages.push_back(it->second);
+    }
+    return messages;
+}
+
+}  // namespace game::state
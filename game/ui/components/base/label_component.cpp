@@ -1,9 +1,33 @@
 #include "game/ui/components/base/label_component.hpp"
 
+#include <algorithm>
+#include <string_view>
 #include <utility>
 
 namespace game::ui::components {
 
+namespace {
+
+auto has_attribute(const std::vector<std::pair<std::string, std::string>>& attributes, std::string_view name)
+    -> bool {
+    return std::any_of(attributes.begin(), attributes.end(), [name](const auto& attribute) {
+        return attribute.first == name;
+    });
+}
+
+}  // namespace
+
+// handlers cannot be compared; only whether there is one counts
+auto props_key(const LabelProps& props) -> engine::ui::PropsKey {
+    engine::ui::PropsKey key{};
+    key.add(props.id).add(props.text).add(props.font_size).add(props.variant_class).add(props.on_click.has_value());
+    key.add(props.attributes.size());
+    for (const auto& [name, value] : props.attributes) {
+        key.add(name).add(value);
+    }
+    return key;
+}
+
 LabelComponent::LabelComponent(LabelProps props)
     : Component<LabelProps>(std::move(props)) {}
 
@@ -11,7 +35,8 @@ auto LabelComponent::render() -> engine::ui::UiElement {
     const auto& data = Component<LabelProps>::props();
 
     engine::ui::UiElement element{};
-    element.tag = data.on_click.has_value() ? "button" : "div";
+    const bool clickable = data.on_click.has_value() || has_attribute(data.attributes, "data-event-click");
+    element.tag = clickable ? "button" : "div";
     element.id = data.id;
     element.classes.push_back("label");
     if (!data.variant_class.empty()) {
@@ -20,6 +45,7 @@ auto LabelComponent::render() -> engine::ui::UiElement {
 
     const std::string style = "font-size: " + std::to_string(data.font_size) + "px;";
     element.attributes.emplace_back("style", style);
+    element.attributes.insert(element.attributes.end(), data.attributes.begin(), data.attributes.end());
     element.text = data.text;
 
     if (data.on_click.has_value()) {
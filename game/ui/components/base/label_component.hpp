@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstddef>
 #include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "engine/ui/ui_component.hpp"
@@ -14,8 +16,12 @@ struct LabelProps {
     int font_size{24};
     std::string variant_class{};
     std::optional<engine::ui::UiEventHandler> on_click{};
+    // extra attributes such as data bindings; data-event-click makes the label a button
+    std::vector<std::pair<std::string, std::string>> attributes{};
 };
 
+[[nodiscard]] auto props_key(const LabelProps& props) -> engine::ui::PropsKey;
+
 class LabelComponent : public engine::ui::Component<LabelProps> {
 public:
     explicit LabelComponent(LabelProps props);
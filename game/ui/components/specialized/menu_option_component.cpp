@@ -4,6 +4,16 @@
 
 namespace game::ui::components {
 
+auto props_key(const MenuOptionProps& props) -> engine::ui::PropsKey {
+    engine::ui::PropsKey key{};
+    key.add(props.id).add(props.label).add(static_cast<bool>(props.on_select));
+    key.add(props.attributes.size());
+    for (const auto& [name, value] : props.attributes) {
+        key.add(name).add(value);
+    }
+    return key;
+}
+
 MenuOptionComponent::MenuOptionComponent(MenuOptionProps props)
     : Component<MenuOptionProps>(std::move(props)) {}
 
@@ -13,7 +23,9 @@ auto MenuOptionComponent::render() -> engine::ui::UiElement {
         .id = data.id,
         .text = data.label,
         .font_size = 28,
-        .variant_class = "option"
+        .variant_class = "option",
+        .on_click = {},
+        .attributes = data.attributes
     };
 
     if (data.on_select) {
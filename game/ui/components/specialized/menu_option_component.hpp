@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstddef>
 #include <functional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "game/ui/components/base/label_component.hpp"
@@ -12,8 +14,11 @@ struct MenuOptionProps {
     std::string id{};
     std::string label{};
     std::function<void()> on_select{};
+    std::vector<std::pair<std::string, std::string>> attributes{};
 };
 
+[[nodiscard]] auto props_key(const MenuOptionProps& props) -> engine::ui::PropsKey;
+
 class MenuOptionComponent : public engine::ui::Component<MenuOptionProps> {
 public:
     explicit MenuOptionComponent(MenuOptionProps props);
@@ -4,6 +4,15 @@
 
 namespace game::ui::components {
 
+auto props_key(const OptionListProps& props) -> engine::ui::PropsKey {
+    engine::ui::PropsKey key{};
+    key.add(props.options.size());
+    for (const auto& option : props.options) {
+        key.add(props_key(option).bytes());
+    }
+    return key;
+}
+
 OptionListComponent::OptionListComponent(OptionListProps props)
     : Component<OptionListProps>(std::move(props)) {}
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <vector>
 
 #include "engine/ui/ui_component.hpp"
@@ -11,6 +12,8 @@ struct OptionListProps {
     std::vector<MenuOptionProps> options{};
 };
 
+[[nodiscard]] auto props_key(const OptionListProps& props) -> engine::ui::PropsKey;
+
 class OptionListComponent : public engine::ui::Component<OptionListProps> {
 public:
     explicit OptionListComponent(OptionListProps props);
@@ -1,5 +1,7 @@
 #include "game/ui/screens/join_friend/join_friend_screen.hpp"
 
+#include <limits>
+#include <optional>
 #include <string>
 #include <utility>
 
@@ -9,6 +11,11 @@ namespace {
 
 constexpr std::string_view kStartMenuScreenId = "start_menu";
 
+// names the markup binds to
+constexpr std::string_view kStatusVariable = "status";
+constexpr std::string_view kChatsVariable = "chats";
+constexpr std::string_view kSelectChatEvent = "select_chat";
+
 }  // namespace
 
 JoinFriendScreen::JoinFriendScreen(game::GameState& state,
@@ -16,7 +23,15 @@ JoinFriendScreen::JoinFriendScreen(game::GameState& state,
                                    game::state::ChatStore& chat_store)
     : state_{&state},
       network_manager_{&network_manager},
-      chat_store_{&chat_store} {}
+      chat_store_{&chat_store} {
+    model_.declare_string(kStatusVariable);
+    model_.declare_list(kChatsVariable);
+    model_.declare_event(kSelectChatEvent, [this](std::size_t index) {
+        if (index < chat_keys_.size()) {
+            handle_select_chat(chat_keys_[index]);
+        }
+    });
+}
 
 auto JoinFriendScreen::id() const noexcept -> std::string_view {
     return kId;
@@ -26,25 +41,49 @@ auto JoinFriendScreen::build() -> engine::ui::UiScreenBuildResult {
     engine::ui::UiElement column{};
     column.tag = "div";
     column.classes = {"screen-content", "center-column"};
+    column.attributes.emplace_back("data-model", model_.name());
 
     game::ui::components::TitleComponent title("JOIN A FRIEND");
-    column.children.push_back(title.render());
+    column.children.push_back(title.render_memo(memo_cache()));
 
-    column.children.push_back(build_status_label());
+    // store changes only touch these bindings, the document itself is built once
+    game::ui::components::LabelComponent status(game::ui::components::LabelProps{
+        .id = "join-friend-status",
+        .text = "{{status}}",
+        .font_size = 20,
+        .variant_class = "subtitle"
+    });
+    column.children.push_back(status.render_memo(memo_cache()));
 
     game::ui::components::OptionListComponent list(
         game::ui::components::OptionListProps{
-            .options = build_options()
+            .options = {
+                game::ui::components::MenuOptionProps{
+                    .id = {},
+                    .label = "{{chat}}",
+                    .on_select = {},
+                    .attributes = {
+                        {"data-for", "chat, i : chats"},
+                        {"data-event-click", "select_chat(i)"}
+                    }
+                },
+                game::ui::components::MenuOptionProps{
+                    .id = "chat-empty",
+                    .label = "No chats available",
+                    .on_select = {},
+                    .attributes = {{"data-if", "chats.size == 0"}}
+                }
+            }
         }
     );
-    column.children.push_back(list.render());
+    column.children.push_back(list.render_memo(memo_cache()));
 
     game::ui::components::MenuOptionComponent back_option(game::ui::components::MenuOptionProps{
         .id = "option-back",
         .label = "Back to Menu",
         .on_select = [this] { handle_back(); }
     });
-    column.children.push_back(back_option.render());
+    column.children.push_back(back_option.render_memo(memo_cache()));
 
     engine::ui::UiScreenBuildResult result{};
     result.root = std::move(column);
@@ -66,21 +105,21 @@ auto JoinFriendScreen::build() -> engine::ui::UiScreenBuildResult {
 void JoinFriendScreen::on_attach(engine::ui::UiScreenHost& host) {
     UiScreen::on_attach(host);
     host_ = &host;
-    last_chat_count_ = 0;
     if (chat_store_ != nullptr) {
-        const auto snapshot = chat_store_->state();
-        last_chat_count_ = snapshot.chats.size();
+        const auto snapshot = chat_store_->snapshot();
+        apply_chat_list(project_chat_list(*snapshot));
+        // the screen binds the chat list and the backend status, nothing else
         chat_subscription_ = chat_store_->subscribe(
-            [this](const game::state::ChatState& snapshot) {
-                last_chat_count_ = snapshot.chats.size();
-                dirty_ = true;
-                if (host_ != nullptr) {
-                    host_->mark_dirty(kId);
-                }
-            }
+            engine::store::Selector<game::state::ChatState, ChatListView>{
+                .version = [](const game::state::ChatState& state) {
+                    return state.versions.chats + state.versions.status;
+                },
+                .project = &JoinFriendScreen::project_chat_list
+            },
+            [this](const ChatListView& view) { apply_chat_list(view); }
         );
-        if (network_manager_ != nullptr && snapshot.chats.empty()) {
-            network_manager_->request_chats(5);
+        if (network_manager_ != nullptr) {
+            request_missing_chats(*snapshot);
         }
     }
 }
@@ -94,74 +133,76 @@ void JoinFriendScreen::on_detach() {
     host_ = nullptr;
 }
 
-auto JoinFriendScreen::update(float /*dt*/) -> bool {
-    const bool was_dirty = dirty_;
-    dirty_ = false;
-    return was_dirty;
+// the chat list is data bound and refreshed on attach
+auto JoinFriendScreen::cacheable() const noexcept -> bool {
+    return true;
 }
 
-auto JoinFriendScreen::build_options() -> std::vector<game::ui::components::MenuOptionProps> {
-    std::vector<game::ui::components::MenuOptionProps> options{};
+auto JoinFriendScreen::expected_next() const -> std::vector<std::string_view> {
+    return {kStartMenuScreenId};
+}
 
-    if (chat_store_ == nullptr) {
-        return options;
-    }
+auto JoinFriendScreen::data_model() noexcept -> engine::ui::UiDataModel* {
+    return &model_;
+}
 
-    const auto chat_state = chat_store_->state();
-    for (const auto& chat : chat_state.chats) {
-        options.push_back(game::ui::components::MenuOptionProps{
-            .id = "chat-" + std::to_string(chat.id),
-            .label = chat.title,
-            .on_select = [this, chat_id = chat.id] { handle_select_chat(chat_id); }
-        });
+auto JoinFriendScreen::project_chat_list(const game::state::ChatState& state) -> ChatListView {
+    ChatListView view{};
+    for (const auto& [account, slice] : state.chats) {
+        for (const auto& chat : slice) {
+            view.titles.push_back(chat.title);
+            view.keys.push_back(engine::backend::ChatKey{chat.account, chat.id});
+        }
     }
 
-    if (options.empty()) {
-        options.push_back(game::ui::components::MenuOptionProps{
-            .id = "chat-empty",
-            .label = "No chats available",
-            .on_select = {}
-        });
+    const bool has_chats = !view.titles.empty();
+    if (state.backend_connecting) {
+        view.status = "Loading chats...";
+    } else if (has_chats) {
+        view.status = "Select a chat to view history.";
+    } else {
+        view.status = "No chats available.";
     }
-
-    return options;
+    return view;
 }
 
-auto JoinFriendScreen::build_status_label() const -> engine::ui::UiElement {
-    bool loading = false;
-    bool has_chats = false;
-    bool ready = false;
-
-    if (chat_store_ != nullptr) {
-        const auto chat_state = chat_store_->state();
-        loading = chat_state.backend_connecting;
-        has_chats = !chat_state.chats.empty();
-        ready = chat_state.backend_ready && has_chats;
-    }
+// the data model only dirties the variables whose value changed
+void JoinFriendScreen::apply_chat_list(ChatListView view) {
+    chat_keys_ = std::move(view.keys);
+    model_.set_string(kStatusVariable, std::move(view.status));
+    model_.set_list(kChatsVariable, std::move(view.titles));
+}
 
-    std::string text;
-    if (loading) {
-        text = "Loading chats...";
-    } else if (ready) {
-        text = "Select a chat to view history.";
-    } else if (!loading && has_chats) {
-        text = "Select a chat to view history.";
-    } else {
-        text = "No chats available.";
+// asks every account that has no chats listed, or only stale ones, for a fresh list
+void JoinFriendScreen::request_missing_chats(const game::state::ChatState& snapshot) {
+    const auto listed = game::state::accounts_in(snapshot.chats);
+    const auto account_count = network_manager_->account_count();
+    for (engine::backend::AccountId account = 0; account < account_count; ++account) {
+        if (!listed.contains(account) || snapshot.stale_accounts.contains(account)) {
+            network_manager_->request_chats(account, static_cast<std::int32_t>(game::state::kVisibleChatCount));
+        }
     }
-
-    game::ui::components::LabelComponent label(game::ui::components::LabelProps{
-        .id = "join-friend-status",
-        .text = text,
-        .font_size = 20,
-        .variant_class = "subtitle"
-    });
-    return label.render();
 }
 
-void JoinFriendScreen::handle_select_chat(engine::backend::ChatId chat_id) {
+void JoinFriendScreen::handle_select_chat(engine::backend::ChatKey chat) {
+    std::optional<game::state::EvictedRange> evicted{};
+    if (chat_store_ != nullptr) {
+        // the first page read crosses into what the memory budget dropped when the chat
+        // holds fewer messages than that
+        evicted = game::state::evicted_range(
+            *chat_store_->snapshot(),
+            chat,
+            std::numeric_limits<engine::backend::MessageId>::max(),
+            game::state::kHistoryPageSize
+        );
+        chat_store_->dispatch(game::state::SelectChat{chat});
+    }
     if (network_manager_ != nullptr) {
-        network_manager_->request_history(chat_id, 10);
+        const auto page = static_cast<std::int32_t>(game::state::kHistoryPageSize);
+        network_manager_->request_history(chat.account, chat.chat_id, page);
+        if (evicted.has_value()) {
+            network_manager_->request_history(chat.account, chat.chat_id, evicted->limit, evicted->before);
+        }
     }
 }
 
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <string>
 #include <string_view>
 #include <vector>
 
 #include "engine/backend/network_manager.hpp"
+#include "engine/ui/ui_data_model.hpp"
 #include "engine/ui/ui_screen.hpp"
 #include "game/state/chat_store.hpp"
 #include "game/state.hpp"
@@ -25,21 +27,32 @@ public:
     [[nodiscard]] auto build() -> engine::ui::UiScreenBuildResult override;
     void on_attach(engine::ui::UiScreenHost& host) override;
     void on_detach() override;
-    auto update(float dt) -> bool override;
+    [[nodiscard]] auto cacheable() const noexcept -> bool override;
+    [[nodiscard]] auto expected_next() const -> std::vector<std::string_view> override;
+    [[nodiscard]] auto data_model() noexcept -> engine::ui::UiDataModel* override;
 
 private:
-    [[nodiscard]] auto build_options() -> std::vector<game::ui::components::MenuOptionProps>;
-    [[nodiscard]] auto build_status_label() const -> engine::ui::UiElement;
-    void handle_select_chat(engine::backend::ChatId chat_id);
+    // what the document binds: the status line and one title per listed chat
+    struct ChatListView {
+        std::string status{};
+        std::vector<std::string> titles{};
+        std::vector<engine::backend::ChatKey> keys{};
+    };
+
+    [[nodiscard]] static auto project_chat_list(const game::state::ChatState& state) -> ChatListView;
+    void apply_chat_list(ChatListView view);
+    void request_missing_chats(const game::state::ChatState& snapshot);
+    void handle_select_chat(engine::backend::ChatKey chat);
     void handle_back();
 
     game::GameState* state_{nullptr};
     engine::backend::NetworkManager* network_manager_{nullptr};
     game::state::ChatStore* chat_store_{nullptr};
     engine::ui::UiScreenHost* host_{nullptr};
-    std::size_t last_chat_count_{0};
+    engine::ui::UiDataModel model_{std::string{kId}};
+    // the chat behind each entry of the bound title list, by index
+    std::vector<engine::backend::ChatKey> chat_keys_{};
     std::size_t chat_subscription_{0};
-    bool dirty_{false};
 };
 
 }  // namespace game::ui::join_friend
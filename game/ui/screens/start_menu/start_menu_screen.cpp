@@ -26,14 +26,14 @@ auto StartMenuScreen::build() -> engine::ui::UiScreenBuildResult {
     column.classes = {"screen-content", "center-column"};
 
     game::ui::components::TitleComponent title("LOUNGE");
-    column.children.push_back(title.render());
+    column.children.push_back(title.render_memo(memo_cache()));
 
     game::ui::components::OptionListComponent list(
         game::ui::components::OptionListProps{
             .options = build_options()
         }
     );
-    column.children.push_back(list.render());
+    column.children.push_back(list.render_memo(memo_cache()));
 
     engine::ui::UiScreenBuildResult result{};
     result.root = std::move(column);
@@ -62,6 +62,15 @@ void StartMenuScreen::on_detach() {
     host_ = nullptr;
 }
 
+// the menu is static
+auto StartMenuScreen::cacheable() const noexcept -> bool {
+    return true;
+}
+
+auto StartMenuScreen::expected_next() const -> std::vector<std::string_view> {
+    return {kJoinFriendScreenId};
+}
+
 void StartMenuScreen::handle_join_friend() {
     if (state_ != nullptr) {
         state_->gameplay_active = false;
@@ -21,6 +21,8 @@ public:
     [[nodiscard]] auto build() -> engine::ui::UiScreenBuildResult override;
     void on_attach(engine::ui::UiScreenHost& host) override;
     void on_detach() override;
+    [[nodiscard]] auto cacheable() const noexcept -> bool override;
+    [[nodiscard]] auto expected_next() const -> std::vector<std::string_view> override;
 
 private:
     void handle_join_friend();